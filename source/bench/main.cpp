@@ -0,0 +1,449 @@
+// Benchmarks for the fracture core. All random input is drawn with a fixed seed so that runs
+// are comparable between commits, results are written as JSON or CSV.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdlib>
+#include <cstdint>
+
+#include "core/geometry.h"
+#include "core/fracture.h"
+#include "core/mesh-clip.h"
+#include "core/kd-tree.h"
+#include "core/point-distribution.h"
+#include "core/thread-pool.h"
+#include "core/vertex-buffer.h"
+#include "core/profiler.h"
+#include "core/count-allocations.h"
+
+namespace
+{
+    struct Options
+    {
+        std::string format = "json";
+        std::string output;
+        std::string filter;
+        std::string label;
+        unsigned repetitions = 5;
+        unsigned num_threads = 0;
+        unsigned max_fragments = 10000;
+        uint64_t seed = 1;
+    };
+
+    struct Result
+    {
+        std::string name, mesh;
+        size_t fragments = 0, items = 0;
+        std::vector<double> seconds;
+
+        // Heap allocations of the last repetition on all threads
+        size_t allocations = 0;
+    };
+
+    using Vec3 = Geometry::Vec3;
+
+    // Keeps results of benchmarks without side effects from being optimized away
+    volatile size_t sink = 0;
+
+    // The quadratic removeDuplicates the grid replaced, kept as reference for speed and output
+    std::vector<Vec3> removeDuplicatesReference(const std::vector<Vec3>& points, double tolerance)
+    {
+        std::vector<Vec3> new_points;
+
+        for (const auto& p0 : points)
+        {
+            bool add = true;
+            for (const auto& p1 : new_points)
+            {
+                if ((p0 - p1).length() < tolerance)
+                {
+                    add = false;
+                    break;
+                }
+            }
+            if (add) new_points.push_back(p0);
+        }
+
+        return new_points;
+    }
+
+    // Stand-in for a scanned object: a closed, bumpy surface with about 100k triangles
+    Geometry::Mesh scanMesh()
+    {
+        return Geometry::sphereMesh(200, 250, 1.0, [](double theta, double phi)
+        {
+            return 1.0 + 0.08 * std::sin(5.0 * theta) * std::cos(7.0 * phi) + 0.03 * std::sin(23.0 * theta + 11.0 * phi);
+        });
+    }
+
+    struct Benchmark
+    {
+        const Options& options;
+        std::vector<Result> results;
+
+        // Runs setup and work repetitions times after one warm-up run, only work is timed
+        void run(const std::string& name, const std::string& mesh, size_t fragments, size_t items,
+            const std::function<void()>& setup, const std::function<void()>& work)
+        {
+            const std::string full_name = name + (mesh.empty() ? "" : "/" + mesh) + (fragments ? "/" + std::to_string(fragments) : "");
+            if (!options.filter.empty() && full_name.find(options.filter) == std::string::npos) return;
+
+            Result result{ name, mesh, fragments, items, {}, 0 };
+
+            for (unsigned r = 0; r <= options.repetitions; r++)
+            {
+                if (setup) setup();
+
+                const size_t allocations = Profiling::totalAllocations();
+                auto begin = std::chrono::steady_clock::now();
+                work();
+                auto end = std::chrono::steady_clock::now();
+                result.allocations = Profiling::totalAllocations() - allocations;
+
+                if (r > 0) result.seconds.push_back(std::chrono::duration<double>(end - begin).count());
+            }
+
+            std::cerr << full_name << ": " << *std::min_element(result.seconds.begin(), result.seconds.end()) << " s\n";
+            results.push_back(result);
+        }
+    };
+
+    struct Summary
+    {
+        double min, median, mean;
+    };
+
+    // Items per second at the median time
+    double throughput(const Result& r, const Summary& s)
+    {
+        return s.median > 0.0 ? r.items / s.median : 0.0;
+    }
+
+    Summary summarize(std::vector<double> seconds)
+    {
+        std::sort(seconds.begin(), seconds.end());
+        const size_t n = seconds.size();
+        return {
+            seconds.front(),
+            n % 2 ? seconds[n / 2] : 0.5 * (seconds[n / 2 - 1] + seconds[n / 2]),
+            std::accumulate(seconds.begin(), seconds.end(), 0.0) / n
+        };
+    }
+
+    void writeJson(std::ostream& out, const Options& options, size_t threads, const std::vector<Result>& results)
+    {
+        out.precision(9);
+        out << "{\n  \"label\": \"" << options.label << "\",\n  \"seed\": " << options.seed
+            << ",\n  \"threads\": " << threads << ",\n  \"repetitions\": " << options.repetitions << ",\n  \"results\": [\n";
+
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const Result& r = results[i];
+            const Summary s = summarize(r.seconds);
+            out << "    { \"name\": \"" << r.name << "\", \"mesh\": \"" << r.mesh << "\", \"fragments\": " << r.fragments
+                << ", \"items\": " << r.items << ", \"min\": " << s.min << ", \"median\": " << s.median << ", \"mean\": " << s.mean
+                << ", \"throughput\": " << throughput(r, s) << ", \"allocations\": " << r.allocations << " }" << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+
+        out << "  ]\n}\n";
+    }
+
+    void writeCsv(std::ostream& out, const Options& options, size_t threads, const std::vector<Result>& results)
+    {
+        out.precision(9);
+        out << "label,seed,threads,name,mesh,fragments,items,repetitions,min,median,mean,throughput,allocations\n";
+
+        for (const Result& r : results)
+        {
+            const Summary s = summarize(r.seconds);
+            out << options.label << ',' << options.seed << ',' << threads << ',' << r.name << ',' << r.mesh << ',' << r.fragments << ','
+                << r.items << ',' << r.seconds.size() << ',' << s.min << ',' << s.median << ',' << s.mean << ',' << throughput(r, s) << ',' << r.allocations << '\n';
+        }
+    }
+
+    void printUsage()
+    {
+        std::cout <<
+            "Usage: voronoi-fracture-bench [flags]\n"
+            "  -format, -f <json|csv>           Output format (json)\n"
+            "  -output, -o <file>               Output file, stdout if not set\n"
+            "  -filter, -fi <string>            Only run benchmarks whose name contains the string\n"
+            "  -label, -l <string>              Label stored with the results, e.g. a commit hash\n"
+            "  -repetitions, -r <unsigned>      Timed repetitions per benchmark (5)\n"
+            "  -num_threads, -nt <unsigned>     Worker threads for fracture, 0 uses all cores (0)\n"
+            "  -max_fragments, -mf <unsigned>   Largest fragment count to fracture with (10000)\n"
+            "  -seed <unsigned>                 Random seed (1)\n";
+    }
+
+    bool parseArguments(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+            if (arg == "-help" || arg == "-h") return false;
+            if (i + 1 >= argc)
+            {
+                std::cerr << "Missing value for " << arg << "\n";
+                return false;
+            }
+
+            const std::string value = argv[++i];
+
+            if (arg == "-format" || arg == "-f") options.format = value;
+            else if (arg == "-output" || arg == "-o") options.output = value;
+            else if (arg == "-filter" || arg == "-fi") options.filter = value;
+            else if (arg == "-label" || arg == "-l") options.label = value;
+            else if (arg == "-repetitions" || arg == "-r") options.repetitions = std::stoul(value);
+            else if (arg == "-num_threads" || arg == "-nt") options.num_threads = std::stoul(value);
+            else if (arg == "-max_fragments" || arg == "-mf") options.max_fragments = std::stoul(value);
+            else if (arg == "-seed") options.seed = std::stoull(value);
+            else
+            {
+                std::cerr << "Unknown flag " << arg << "\n";
+                return false;
+            }
+        }
+
+        return (options.format == "json" || options.format == "csv") && options.repetitions > 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    try
+    {
+        if (!parseArguments(argc, argv, options))
+        {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid flag value\n";
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    const std::vector<std::pair<std::string, Geometry::Mesh>> meshes = {
+        { "cube", Geometry::boxMesh(Vec3(-1, -1, -1), Vec3(1, 1, 1)) },
+        { "sphere", Geometry::sphereMesh(32, 64, 1.0) },
+        { "torus", Geometry::torusMesh(64, 32, 1.0, 0.4) },
+        { "scan", scanMesh() }
+    };
+
+    ThreadPool pool(options.num_threads);
+    Benchmark bench{ options, {} };
+
+    // Seed distributions, batch versions fill a structure of arrays buffer
+    const size_t num_points = 1000000;
+    const Vec3 center(0, 0, 0);
+    const std::array<Vec3, 3> axes = { Vec3(1, 0, 0), Vec3(0, 1, 0), Vec3(0, 0, 1) };
+    std::vector<Vec3> points;
+
+    bench.run("uniformBoundingBox", "", 0, num_points, nullptr,
+        [&] { points = PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), num_points, options.seed, &pool); });
+    bench.run("sphereQuadratic", "", 0, num_points, nullptr,
+        [&] { points = PointDistribution::sphereQuadratic(center, axes, num_points, options.seed, &pool); });
+    bench.run("diskQuadratic", "", 0, num_points, nullptr,
+        [&] { points = PointDistribution::diskQuadratic(center, axes, 3, num_points, options.seed, &pool); });
+    bench.run("sphereSteps", "", 0, num_points, nullptr,
+        [&] { points = PointDistribution::sphereSteps(center, axes, 10, 0.05, num_points, options.seed, &pool); });
+    bench.run("diskSteps", "", 0, num_points, nullptr,
+        [&] { points = PointDistribution::diskSteps(center, axes, 10, 3, 0.05, num_points, options.seed, &pool); });
+
+    // Helix standing in for a long hand drawn curve
+    PointDistribution::CurveTable helix;
+    for (size_t i = 0; i <= 10000; i++)
+    {
+        const double t = 0.01 * i;
+        helix.add(Vec3(std::cos(t), std::sin(t), 0.05 * t), Vec3(-std::sin(t), std::cos(t), 0.05).normal());
+    }
+
+    bench.run("curves", "", 0, num_points, nullptr,
+        [&] { points = PointDistribution::curves({ helix }, 0.1, num_points, options.seed, &pool); });
+
+    Geometry::VertexBuffer seed_buffer;
+
+    bench.run("batchUniformBoundingBox", "", 0, num_points, nullptr,
+        [&] { PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), num_points, options.seed, seed_buffer, &pool); });
+    bench.run("batchSphereQuadratic", "", 0, num_points, nullptr,
+        [&] { PointDistribution::sphereQuadratic(center, axes, num_points, options.seed, seed_buffer, &pool); });
+    bench.run("batchDiskQuadratic", "", 0, num_points, nullptr,
+        [&] { PointDistribution::diskQuadratic(center, axes, 3, num_points, options.seed, seed_buffer, &pool); });
+    bench.run("batchSphereSteps", "", 0, num_points, nullptr,
+        [&] { PointDistribution::sphereSteps(center, axes, 10, 0.05, num_points, options.seed, seed_buffer, &pool); });
+    bench.run("batchDiskSteps", "", 0, num_points, nullptr,
+        [&] { PointDistribution::diskSteps(center, axes, 10, 3, 0.05, num_points, options.seed, seed_buffer, &pool); });
+
+    const size_t num_unique = 100000;
+    bench.run("removeDuplicates", "", 0, num_unique,
+        [&] { points = PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), num_unique, options.seed); },
+        [&] { points = PointDistribution::removeDuplicates(points, 1e-2); });
+
+    std::vector<Vec3> reference;
+    bench.run("removeDuplicatesReference", "", 0, num_unique,
+        [&] { reference = PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), num_unique, options.seed); },
+        [&] { reference = removeDuplicatesReference(reference, 1e-2); });
+
+    // Both keep the first of each group of close points, so they must agree exactly
+    if (!reference.empty())
+    {
+        const std::vector<Vec3> grid = PointDistribution::removeDuplicates(
+            PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), num_unique, options.seed), 1e-2);
+        const bool same = reference.size() == grid.size() && std::equal(reference.begin(), reference.end(), grid.begin(),
+            [](const Vec3& a, const Vec3& b) { return a.x == b.x && a.y == b.y && a.z == b.z; });
+        if (!same)
+        {
+            std::cerr << "removeDuplicates kept " << grid.size() << " points, the reference " << reference.size() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    bench.run("mortonOrder", "", 0, num_points,
+        [&] { points = PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), num_points, options.seed, &pool); },
+        [&] { points = PointDistribution::sortSpatially(points, PointDistribution::Curve::MORTON); });
+    bench.run("hilbertOrder", "", 0, num_points,
+        [&] { points = PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), num_points, options.seed, &pool); },
+        [&] { points = PointDistribution::sortSpatially(points, PointDistribution::Curve::HILBERT); });
+
+    // Builds the seed index and walks the nearest neighbours of some seeds, as building
+    // their cells does
+    for (size_t num_seeds = 10000; num_seeds <= 1000000; num_seeds *= 10)
+    {
+        const size_t num_queries = 10000, num_neighbours = 32;
+        bench.run("kdTree", "", num_seeds, num_seeds,
+            [&] { points = PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), num_seeds, options.seed, &pool); },
+            [&]
+            {
+                KdTree<Vec3> tree(points);
+                KdTree<Vec3>::Query query;
+                size_t index, sum = 0;
+                double distance2;
+                for (size_t i = 0; i < num_queries; i++)
+                {
+                    query.reset(tree, points[i * num_seeds / num_queries]);
+                    for (size_t j = 0; j < num_neighbours && query.next(index, distance2); j++) sum += index;
+                }
+                sink = sum;
+            });
+    }
+
+    for (const auto& [mesh_name, mesh] : meshes)
+    {
+        // Plane classification against bisectors of the origin and random points in the bounds,
+        // which exercises the filter of the exact side test
+        const size_t num_planes = 1000;
+        Geometry::VertexBuffer buffer(mesh.vertices);
+        std::vector<Geometry::Plane> planes;
+
+        bench.run("planeClassification", mesh_name, 0, num_planes,
+            [&]
+            {
+                planes.clear();
+                for (const Vec3& p : PointDistribution::uniformBoundingBox(buffer.bounds.min, buffer.bounds.max, num_planes, options.seed))
+                    planes.push_back(Geometry::getBisectorPlane(Vec3(), p));
+            },
+            [&]
+            {
+                bool strictly_greater;
+                size_t hits = 0;
+                for (const auto& plane : planes) hits += Geometry::intersects(plane, buffer, strictly_greater);
+                sink = hits;
+            });
+
+        // One clip and cap through the center of the mesh
+        Geometry::MeshClipper clipper;
+        Geometry::Mesh clipped;
+        const Vec3 center = (buffer.bounds.min + buffer.bounds.max) * 0.5, offset(0.3, 0.5, 0.8);
+        const Geometry::Plane plane = Geometry::getBisectorPlane(center - offset, center + offset);
+
+        bench.run("clipAndCap", mesh_name, 0, mesh.polygon_counts.size(),
+            [&] { clipped = mesh; },
+            [&] { clipper.clipAndCap(clipped, plane, 0); });
+
+        // Whole object fracture
+        Geometry::Bounds bounds;
+        bounds.compute(mesh.vertices);
+
+        for (unsigned fragments = 10; fragments <= options.max_fragments; fragments *= 10)
+        {
+            std::vector<Vec3> seeds;
+            std::vector<Geometry::Mesh> result;
+
+            bench.run("fracture", mesh_name, fragments, fragments,
+                [&] { seeds = PointDistribution::uniformBoundingBox(bounds.min, bounds.max, fragments, options.seed); },
+                [&] { result = Fracture::fractureMesh(mesh, seeds, bounds.min, bounds.max, pool); });
+
+            // Same seeds sorted along a space filling curve, so consecutive cells visit the same
+            // nodes of the seed index and every worker gets a compact region. Every benchmark
+            // draws its own seeds, so they also run when -filter skips the others.
+            if (fragments >= 10000)
+            {
+                std::vector<Vec3> sorted;
+
+                bench.run("fractureMorton", mesh_name, fragments, fragments,
+                    [&]
+                    {
+                        sorted = PointDistribution::sortSpatially(
+                            PointDistribution::uniformBoundingBox(bounds.min, bounds.max, fragments, options.seed), PointDistribution::Curve::MORTON);
+                    },
+                    [&] { result = Fracture::fractureMesh(mesh, sorted, bounds.min, bounds.max, pool); });
+                bench.run("fractureHilbert", mesh_name, fragments, fragments,
+                    [&]
+                    {
+                        sorted = PointDistribution::sortSpatially(
+                            PointDistribution::uniformBoundingBox(bounds.min, bounds.max, fragments, options.seed), PointDistribution::Curve::HILBERT);
+                    },
+                    [&] { result = Fracture::fractureMesh(mesh, sorted, bounds.min, bounds.max, pool); });
+            }
+
+            // Rerun after moving 1% of the seeds, as when an artist nudges a few particles
+            Fracture::Level level;
+            std::vector<Vec3> moved;
+
+            bench.run("refracture", mesh_name, fragments, fragments,
+                [&]
+                {
+                    moved = PointDistribution::uniformBoundingBox(bounds.min, bounds.max, fragments, options.seed);
+                    level = Fracture::fractureLevel(mesh, moved, bounds.min, bounds.max, pool);
+
+                    const size_t num_moved = std::max<size_t>(fragments / 100, 1);
+                    const auto targets = PointDistribution::uniformBoundingBox(bounds.min, bounds.max, num_moved, options.seed + 1);
+                    for (size_t i = 0; i < num_moved; i++) moved[i * (fragments / num_moved)] = targets[i];
+                },
+                [&] { sink = Fracture::refracture(level, mesh, moved, bounds.min, bounds.max, pool); });
+        }
+
+    }
+
+    if (options.output.empty())
+    {
+        if (options.format == "json") writeJson(std::cout, options, pool.size(), bench.results);
+        else writeCsv(std::cout, options, pool.size(), bench.results);
+    }
+    else
+    {
+        std::ofstream out(options.output);
+        if (!out)
+        {
+            std::cerr << "Unable to write " << options.output << "\n";
+            return EXIT_FAILURE;
+        }
+
+        if (options.format == "json") writeJson(out, options, pool.size(), bench.results);
+        else writeCsv(out, options, pool.size(), bench.results);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,420 @@
+// Command line driver for the fracture core, usable without Maya. Reads an OBJ or PLY mesh,
+// distributes seeds and writes one file per fragment to an output directory.
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <array>
+#include <chrono>
+#include <filesystem>
+#include <cstdlib>
+#include <memory>
+
+#include "core/geometry.h"
+#include "core/fracture.h"
+#include "core/contacts.h"
+#include "core/mesh-io.h"
+#include "core/point-distribution.h"
+#include "core/thread-pool.h"
+#include "core/vertex-buffer.h"
+#include "core/profiler.h"
+#include "core/log.h"
+#include "core/count-allocations.h"
+
+namespace
+{
+    struct Options
+    {
+        std::string input, output;
+        std::string format;
+
+        unsigned num_fragments = 5;
+        unsigned sub_fragments = 0;
+        unsigned batch_size = 0;
+        unsigned num_threads = 0;
+        unsigned steps = 0;
+        double step_noise = 0.05;
+        double min_distance = 0.0;
+        std::string disk_axis;
+        PointDistribution::Curve seed_order = PointDistribution::Curve::NONE;
+
+        bool profile = false;
+        std::string trace;
+        std::string contacts;
+        unsigned verbosity = 2;
+        uint64_t seed = 0;
+
+        // Sphere to distribute seeds in, the bounding box of the mesh is used if not set
+        bool use_sphere = false;
+        Geometry::Vec3 sphere_center;
+        double sphere_radius = 1.0;
+    };
+
+    void printUsage()
+    {
+        std::cout <<
+            "Usage: voronoi-fracture <input.obj|ply> <output directory> [flags]\n"
+            "  -num_fragments, -nf <unsigned>     Number of fragments (5)\n"
+            "  -sub_fragments, -sf <unsigned>     Split every fragment again into this many pieces (0)\n"
+            "  -batch_size, -bs <unsigned>        Write fragments in batches of this many seeds, 0 keeps all (0)\n"
+            "  -min_distance, -md <double>        Minimum distance between seeds (0)\n"
+            "  -num_threads, -nt <unsigned>       Worker threads, 0 uses all cores (0)\n"
+            "  -sphere, -sp <x> <y> <z> <radius>  Distribute seeds in a sphere instead of the bounding box\n"
+            "  -disk_axis, -da <x|y|z>            Flatten the sphere distribution to a disk\n"
+            "  -steps, -s <unsigned>              Distribute seeds in rings of the sphere (0)\n"
+            "  -step_noise, -sn <double>          Noise added to ring distributions (0.05)\n"
+            "  -seed_order, -so <none|morton|hilbert>  Sort seeds along a space filling curve (none)\n"
+            "  -format, -f <obj|ply>              Output format, same as input by default\n"
+            "  -profile, -p                       Print a JSON report of phase times and plane counters\n"
+            "  -trace, -tr <file>                 Write a Chrome trace of all phases and fragments\n"
+            "  -contacts, -con <file>             Write the fragment pairs sharing a face and its area as CSV\n"
+            "  -verbosity, -vb <0-3>              Errors, warnings, info or debug output (2)\n"
+            "  -seed, -sd <unsigned>              Random seed, 0 draws a new one (0)\n";
+    }
+
+    bool parseArguments(int argc, char** argv, Options& options)
+    {
+        std::vector<std::string> positional;
+
+        for (int i = 1; i < argc; i++)
+        {
+            const std::string arg = argv[i];
+
+            auto value = [&](int count = 1) -> bool
+            {
+                if (i + count >= argc)
+                {
+                    std::cerr << "Missing value for " << arg << "\n";
+                    return false;
+                }
+                return true;
+            };
+
+            if (arg == "-num_fragments" || arg == "-nf")
+            {
+                if (!value()) return false;
+                options.num_fragments = std::stoul(argv[++i]);
+            }
+            else if (arg == "-sub_fragments" || arg == "-sf")
+            {
+                if (!value()) return false;
+                options.sub_fragments = std::stoul(argv[++i]);
+            }
+            else if (arg == "-batch_size" || arg == "-bs")
+            {
+                if (!value()) return false;
+                options.batch_size = std::stoul(argv[++i]);
+            }
+            else if (arg == "-min_distance" || arg == "-md")
+            {
+                if (!value()) return false;
+                options.min_distance = std::stod(argv[++i]);
+            }
+            else if (arg == "-num_threads" || arg == "-nt")
+            {
+                if (!value()) return false;
+                options.num_threads = std::stoul(argv[++i]);
+            }
+            else if (arg == "-sphere" || arg == "-sp")
+            {
+                if (!value(4)) return false;
+                options.use_sphere = true;
+                options.sphere_center.x = std::stod(argv[++i]);
+                options.sphere_center.y = std::stod(argv[++i]);
+                options.sphere_center.z = std::stod(argv[++i]);
+                options.sphere_radius = std::stod(argv[++i]);
+            }
+            else if (arg == "-disk_axis" || arg == "-da")
+            {
+                if (!value()) return false;
+                options.disk_axis = argv[++i];
+            }
+            else if (arg == "-steps" || arg == "-s")
+            {
+                if (!value()) return false;
+                options.steps = std::stoul(argv[++i]);
+            }
+            else if (arg == "-step_noise" || arg == "-sn")
+            {
+                if (!value()) return false;
+                options.step_noise = std::stod(argv[++i]);
+            }
+            else if (arg == "-seed_order" || arg == "-so")
+            {
+                if (!value()) return false;
+                const std::string order = argv[++i];
+                if (order == "none") options.seed_order = PointDistribution::Curve::NONE;
+                else if (order == "morton") options.seed_order = PointDistribution::Curve::MORTON;
+                else if (order == "hilbert") options.seed_order = PointDistribution::Curve::HILBERT;
+                else
+                {
+                    std::cerr << "-seed_order must be none, morton or hilbert\n";
+                    return false;
+                }
+            }
+            else if (arg == "-format" || arg == "-f")
+            {
+                if (!value()) return false;
+                options.format = argv[++i];
+            }
+            else if (arg == "-profile" || arg == "-p")
+            {
+                options.profile = true;
+            }
+            else if (arg == "-trace" || arg == "-tr")
+            {
+                if (!value()) return false;
+                options.trace = argv[++i];
+            }
+            else if (arg == "-contacts" || arg == "-con")
+            {
+                if (!value()) return false;
+                options.contacts = argv[++i];
+            }
+            else if (arg == "-verbosity" || arg == "-vb")
+            {
+                if (!value()) return false;
+                options.verbosity = std::stoul(argv[++i]);
+            }
+            else if (arg == "-seed" || arg == "-sd")
+            {
+                if (!value()) return false;
+                options.seed = std::stoull(argv[++i]);
+            }
+            else if (arg == "-help" || arg == "-h")
+            {
+                return false;
+            }
+            else if (!arg.empty() && arg[0] == '-')
+            {
+                std::cerr << "Unknown flag " << arg << "\n";
+                return false;
+            }
+            else
+            {
+                positional.push_back(arg);
+            }
+        }
+
+        if (positional.size() != 2) return false;
+
+        options.input = positional[0];
+        options.output = positional[1];
+
+        if (options.format.empty())
+        {
+            options.format = std::filesystem::path(options.input).extension().string();
+            if (!options.format.empty()) options.format.erase(0, 1);
+        }
+
+        return options.format == "obj" || options.format == "ply";
+    }
+
+    std::vector<Geometry::Vec3> generateSeedPoints(const Options& options, const Geometry::Bounds& bounds, uint64_t seed, ThreadPool& pool)
+    {
+        std::vector<Geometry::Vec3> points;
+
+        if (options.use_sphere)
+        {
+            size_t disk_axis_i = 0;
+            if (options.disk_axis == "x") disk_axis_i = 1;
+            else if (options.disk_axis == "y") disk_axis_i = 2;
+            else if (options.disk_axis == "z") disk_axis_i = 3;
+
+            const double r = options.sphere_radius;
+            const std::array<Geometry::Vec3, 3> axes = {
+                Geometry::Vec3(r, 0, 0), Geometry::Vec3(0, r, 0), Geometry::Vec3(0, 0, r)
+            };
+
+            if (disk_axis_i == 0)
+            {
+                if (options.steps == 0)
+                    points = PointDistribution::sphereQuadratic(options.sphere_center, axes, options.num_fragments, seed, &pool);
+                else
+                    points = PointDistribution::sphereSteps(options.sphere_center, axes, options.steps, options.step_noise, options.num_fragments, seed, &pool);
+            }
+            else
+            {
+                if (options.steps == 0)
+                    points = PointDistribution::diskQuadratic(options.sphere_center, axes, disk_axis_i, options.num_fragments, seed, &pool);
+                else
+                    points = PointDistribution::diskSteps(options.sphere_center, axes, options.steps, disk_axis_i, options.step_noise, options.num_fragments, seed, &pool);
+            }
+        }
+        else
+        {
+            points = PointDistribution::uniformBoundingBox(bounds.min, bounds.max, options.num_fragments, seed, &pool);
+        }
+
+        return PointDistribution::sortSpatially(PointDistribution::removeDuplicates(points, options.min_distance), options.seed_order);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+
+    try
+    {
+        if (!parseArguments(argc, argv, options))
+        {
+            printUsage();
+            return EXIT_FAILURE;
+        }
+    }
+    catch (const std::exception&)
+    {
+        std::cerr << "Invalid flag value\n";
+        printUsage();
+        return EXIT_FAILURE;
+    }
+
+    const auto level = static_cast<Log::Level>(std::min(options.verbosity, (unsigned)Log::Level::DEBUG));
+    Log::Logger logger(level, [](Log::Level l, const std::string& message)
+    {
+        (l <= Log::Level::WARNING ? std::cerr : std::cout) << message << "\n";
+    });
+
+    std::unique_ptr<Profiling::Profiler> profiler;
+    if (options.profile || !options.trace.empty()) profiler = std::make_unique<Profiling::Profiler>();
+
+    Geometry::Mesh source;
+    {
+        Profiling::Profiler::Scope scope(profiler.get(), "readMesh");
+        if (!MeshIO::read(options.input, source))
+        {
+            std::cerr << "Unable to read " << options.input << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    Geometry::Bounds bounds;
+    bounds.compute(source.vertices);
+
+    ThreadPool pool(options.num_threads);
+
+    // 0 draws a new seed, which is logged so the result can be reproduced
+    const uint64_t seed = options.seed != 0 ? options.seed : Random::randomSeed();
+
+    std::vector<Geometry::Vec3> seeds;
+    {
+        Profiling::Profiler::Scope scope(profiler.get(), "generateSeedPoints");
+        seeds = generateSeedPoints(options, bounds, seed, pool);
+    }
+    if (seeds.empty())
+    {
+        std::cerr << "Generated point distribution is empty.\n";
+        return EXIT_FAILURE;
+    }
+
+    std::error_code error;
+    std::filesystem::create_directories(options.output, error);
+    if (error)
+    {
+        std::cerr << "Unable to create " << options.output << ": " << error.message() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // Fragments of a closed mesh must be closed as well
+    const bool source_closed = Geometry::isClosed(source);
+    size_t written = 0, num_open = 0;
+    auto write = [&](size_t i, const Geometry::Mesh& fragment)
+    {
+        if (source_closed && !Geometry::isClosed(fragment)) num_open++;
+
+        const std::filesystem::path path = std::filesystem::path(options.output) / ("fragment_" + std::to_string(i) + "." + options.format);
+        if (!MeshIO::write(path.string(), fragment))
+        {
+            std::cerr << "Unable to write " << path.string() << "\n";
+            return false;
+        }
+        written++;
+        return true;
+    };
+
+    auto begin = std::chrono::high_resolution_clock::now();
+
+    Geometry::PlaneTestStats plane_stats;
+
+    // Fragment pairs for glue constraints, indexed like the written files
+    std::vector<Fracture::Contact> contacts;
+
+    if (options.batch_size > 0)
+    {
+        if (options.sub_fragments > 0) LOG(logger, Log::Level::WARNING, "-sub_fragments is ignored with -batch_size.");
+
+        // Fragments are written as their batch completes instead of all at the end
+        const bool completed = Fracture::fractureBatches(source, seeds, bounds.min, bounds.max, pool, options.batch_size,
+            [&](size_t i, Geometry::Mesh& fragment)
+            {
+                LOG(logger, Log::Level::DEBUG, "Fragment " << i << " for point: " << seeds[i].x << ", " << seeds[i].y << ", " << seeds[i].z
+                    << " has " << fragment.polygon_counts.size() << " faces.");
+                if (!options.contacts.empty()) Fracture::addContacts(fragment, i, contacts);
+                return write(i, fragment);
+            },
+            &plane_stats, profiler.get()
+        );
+        if (!completed) return EXIT_FAILURE;
+
+        Fracture::sortContacts(contacts);
+    }
+    else
+    {
+        std::vector<Geometry::Mesh> fragments;
+        if (options.sub_fragments == 0)
+        {
+            fragments = Fracture::fractureMesh(source, seeds, bounds.min, bounds.max, pool, &plane_stats, profiler.get());
+        }
+        else
+        {
+            // Fine seeds replace the coarse ones, fragments are named after them. The profiler
+            // keeps the fragments of both levels, the fine ones after the coarse ones.
+            Fracture::Level fine = Fracture::subFracture(
+                Fracture::fractureLevel(source, seeds, bounds.min, bounds.max, pool, &plane_stats, profiler.get()),
+                options.sub_fragments, seed, options.min_distance, pool, &plane_stats, profiler.get()
+            );
+            if (!options.contacts.empty()) contacts = Fracture::contacts(fine);
+            for (auto& fragment : fine.fragments) fragments.push_back(std::move(*fragment));
+            seeds = std::move(fine.seeds);
+        }
+        if (!options.contacts.empty() && options.sub_fragments == 0) contacts = Fracture::contacts(fragments);
+
+        Profiling::Profiler::Scope scope(profiler.get(), "writeMeshes");
+
+        for (size_t i = 0; i < fragments.size(); i++)
+        {
+            LOG(logger, Log::Level::DEBUG, "Fragment " << i << " for point: " << seeds[i].x << ", " << seeds[i].y << ", " << seeds[i].z
+                << " has " << fragments[i].polygon_counts.size() << " faces.");
+
+            if (!fragments[i].empty() && !write(i, fragments[i])) return EXIT_FAILURE;
+        }
+    }
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - begin);
+
+    if (num_open > 0) LOG(logger, Log::Level::WARNING, num_open << " fragments of the closed mesh are not watertight.");
+    LOG(logger, Log::Level::INFO, "Fractured " << options.input << " into " << written << " fragments from " << seeds.size()
+        << " seeds in " << duration.count() * 1e-6 << " seconds using " << pool.size() << " threads, seed " << seed << ".");
+    LOG(logger, Log::Level::DEBUG, "Planes resolved by bounding sphere: " << plane_stats.sphere << ", bounding box: " << plane_stats.box
+        << ", vertices: " << plane_stats.vertices << ". Planes clipped: " << plane_stats.clipped << ".");
+    logger.flush();
+
+    if (!options.contacts.empty() && !Fracture::writeContacts(options.contacts, contacts))
+    {
+        std::cerr << "Unable to write " << options.contacts << "\n";
+        return EXIT_FAILURE;
+    }
+
+    if (profiler)
+    {
+        if (options.profile) std::cout << profiler->report() << "\n";
+
+        if (!options.trace.empty() && !profiler->writeChromeTrace(options.trace))
+        {
+            std::cerr << "Unable to write " << options.trace << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+#include "contacts.h"
+
+#include <algorithm>
+#include <fstream>
+#include <utility>
+
+namespace
+{
+    double polygonArea(const std::vector<Geometry::Vec3>& polygon)
+    {
+        Geometry::Vec3 sum;
+        for (size_t j = 1; j + 1 < polygon.size(); j++)
+        {
+            sum += (polygon[j] - polygon[0]) ^ (polygon[j + 1] - polygon[0]);
+        }
+        return 0.5 * sum.length();
+    }
+
+    // Keeps the part of a planar polygon below plane, concave polygons may get degenerate
+    // edges along the plane which don't change the area
+    void clipPolygon(std::vector<Geometry::Vec3>& polygon, const Geometry::Plane& plane, std::vector<Geometry::Vec3>& scratch)
+    {
+        scratch.clear();
+        for (size_t j = 0; j < polygon.size(); j++)
+        {
+            const Geometry::Vec3& a = polygon[j];
+            const Geometry::Vec3& b = polygon[(j + 1) % polygon.size()];
+            const double d_a = plane.signedDistance(a), d_b = plane.signedDistance(b);
+            const bool a_inside = plane.side(a, d_a) < 0, b_inside = plane.side(b, d_b) < 0;
+
+            if (a_inside) scratch.push_back(a);
+            if (a_inside != b_inside)
+            {
+                const double t = d_a != d_b ? std::min(std::max(d_a / (d_a - d_b), 0.0), 1.0) : 0.0;
+                scratch.push_back(a + (b - a) * t);
+            }
+        }
+        std::swap(polygon, scratch);
+    }
+
+    // Contacts of fine fragments through the faces of their parents. Each face between two
+    // parents is handled from the parent with the lower index, and its part on a fine fragment
+    // is intersected with the fine cells of the other parent that can be closest to it.
+    void addParentContacts(const Fracture::Level& level, std::vector<Fracture::Contact>& contacts)
+    {
+        const std::vector<size_t>& parents = level.parents;
+        std::vector<Geometry::Vec3> polygon, clipped, scratch;
+
+        for (size_t k = 0; k < level.fragments.size(); k++)
+        {
+            const Geometry::Mesh& fragment = *level.fragments[k];
+
+            size_t offset = 0;
+            for (size_t f = 0; f < fragment.polygon_counts.size(); f++)
+            {
+                const int count = fragment.polygon_counts[f];
+                const int tag = fragment.polygon_tags[f];
+                offset += count;
+
+                if (tag > -2 || (size_t)(-2 - tag) <= parents[k]) continue;
+
+                const auto range = std::equal_range(parents.begin(), parents.end(), (size_t)(-2 - tag));
+                if (range.first == range.second) continue;
+
+                polygon.clear();
+                Geometry::Vec3 center;
+                for (int j = 0; j < count; j++)
+                {
+                    polygon.push_back(fragment.vertices[fragment.polygon_connects[offset - count + j]]);
+                    center += polygon.back();
+                }
+                center = center / count;
+
+                double radius = 0.0;
+                for (const auto& v : polygon) radius = std::max(radius, (v - center).length());
+
+                // A point of the polygon is at most radius from the center and the seed closest
+                // to the center, so the seed closest to that point is within 2 radius of it
+                const size_t first = range.first - parents.begin(), last = range.second - parents.begin();
+                double nearest = (level.seeds[first] - center).length();
+                for (size_t m = first + 1; m < last; m++) nearest = std::min(nearest, (level.seeds[m] - center).length());
+                const double reach = (2.0 * radius + nearest) * (1.0 + 1e-9);
+
+                for (size_t m = first; m < last; m++)
+                {
+                    if ((level.seeds[m] - center).length() > reach) continue;
+
+                    clipped = polygon;
+                    for (const auto& plane : level.cells[m]->planes)
+                    {
+                        clipPolygon(clipped, plane, scratch);
+                        if (clipped.size() < 3) break;
+                    }
+
+                    const double area = clipped.size() >= 3 ? polygonArea(clipped) : 0.0;
+                    if (area > 0.0) contacts.push_back({ k, m, area });
+                }
+            }
+        }
+    }
+}
+
+void Fracture::addContacts(const Geometry::Mesh& fragment, size_t index, std::vector<Contact>& contacts)
+{
+    // Caps towards the same neighbour may be split into several polygons
+    std::vector<std::pair<size_t, double>> areas;
+    std::vector<Geometry::Vec3> polygon;
+
+    size_t offset = 0;
+    for (size_t f = 0; f < fragment.polygon_counts.size(); f++)
+    {
+        const int count = fragment.polygon_counts[f];
+        const int tag = fragment.polygon_tags[f];
+        offset += count;
+
+        if (tag < 0 || (size_t)tag <= index) continue;
+
+        polygon.clear();
+        for (int j = 0; j < count; j++) polygon.push_back(fragment.vertices[fragment.polygon_connects[offset - count + j]]);
+
+        auto it = std::find_if(areas.begin(), areas.end(), [tag](const std::pair<size_t, double>& a) { return a.first == (size_t)tag; });
+        if (it == areas.end())
+            areas.emplace_back(tag, polygonArea(polygon));
+        else
+            it->second += polygonArea(polygon);
+    }
+
+    for (const auto& [neighbour, area] : areas)
+    {
+        if (area > 0.0) contacts.push_back({ index, neighbour, area });
+    }
+}
+
+std::vector<Fracture::Contact> Fracture::contacts(const std::vector<Geometry::Mesh>& fragments)
+{
+    std::vector<Contact> result;
+    for (size_t i = 0; i < fragments.size(); i++) addContacts(fragments[i], i, result);
+
+    sortContacts(result);
+    return result;
+}
+
+std::vector<Fracture::Contact> Fracture::contacts(const Level& level)
+{
+    std::vector<Contact> result;
+    for (size_t i = 0; i < level.fragments.size(); i++) addContacts(*level.fragments[i], i, result);
+
+    if (!level.parents.empty() && level.cells.size() == level.fragments.size()) addParentContacts(level, result);
+
+    sortContacts(result);
+
+    // A fine fragment may touch the same fragment of another parent through several polygons
+    size_t n = 0;
+    for (size_t i = 0; i < result.size(); i++)
+    {
+        if (n > 0 && result[n - 1].a == result[i].a && result[n - 1].b == result[i].b)
+            result[n - 1].area += result[i].area;
+        else
+            result[n++] = result[i];
+    }
+    result.resize(n);
+
+    return result;
+}
+
+void Fracture::sortContacts(std::vector<Contact>& contacts)
+{
+    std::sort(contacts.begin(), contacts.end(), [](const Contact& x, const Contact& y)
+    {
+        return x.a != y.a ? x.a < y.a : x.b < y.b;
+    });
+}
+
+void Fracture::renumberContacts(std::vector<Contact>& contacts, const std::vector<size_t>& numbers)
+{
+    for (auto& contact : contacts)
+    {
+        contact.a = numbers[contact.a];
+        contact.b = numbers[contact.b];
+        if (contact.a > contact.b) std::swap(contact.a, contact.b);
+    }
+
+    sortContacts(contacts);
+}
+
+bool Fracture::writeContacts(const std::string& path, const std::vector<Contact>& contacts)
+{
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out.precision(9);
+    out << "a,b,area\n";
+    for (const auto& contact : contacts) out << contact.a << ',' << contact.b << ',' << contact.area << '\n';
+
+    return (bool)out;
+}
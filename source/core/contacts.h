@@ -0,0 +1,41 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstddef>
+
+#include "geometry.h"
+#include "fracture.h"
+
+namespace Fracture
+{
+    // Two fragments that share a face and the area of that face, with a < b
+    struct Contact
+    {
+        size_t a, b;
+        double area;
+    };
+
+    // Appends the contacts of fragment index with fragments of higher index, from the areas
+    // of its caps, which are tagged with the index of the fragment on their other side.
+    // Calling it for every fragment lists each contact once, also while fragments stream.
+    void addContacts(const Geometry::Mesh& fragment, size_t index, std::vector<Contact>& contacts);
+
+    // Contacts between fragments indexed like their seeds, sorted by a and b
+    std::vector<Contact> contacts(const std::vector<Geometry::Mesh>& fragments);
+
+    // Same for a level. Fine fragments of subFracture are also matched across the faces
+    // between their parents, by intersecting each face with the fine cells on its other side.
+    std::vector<Contact> contacts(const Level& level);
+
+    // Sorts by a and b, e.g. contacts added in the order fragments were streamed
+    void sortContacts(std::vector<Contact>& contacts);
+
+    // Replaces fragment indices by numbers[index], e.g. the names of non-empty fragments,
+    // and sorts again
+    void renumberContacts(std::vector<Contact>& contacts, const std::vector<size_t>& numbers);
+
+    // Writes a header and one "a,b,area" line per contact. Returns false if the file can't
+    // be written.
+    bool writeContacts(const std::string& path, const std::vector<Contact>& contacts);
+}
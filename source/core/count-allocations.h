@@ -0,0 +1,23 @@
+#pragma once
+
+#include <new>
+#include <cstddef>
+
+#include "profiler.h"
+
+// Replaces the global operator new and delete with versions that count allocations per thread,
+// which the profiler then reports per fragment. Include in exactly one source file of a
+// program. Over-aligned allocations keep the default functions and aren't counted.
+
+namespace
+{
+    const bool counting_enabled = (Profiling::Detail::counting = true);
+}
+
+void* operator new(std::size_t size) { return Profiling::Detail::allocate(size); }
+void* operator new[](std::size_t size) { return Profiling::Detail::allocate(size); }
+
+void operator delete(void* p) noexcept { Profiling::Detail::deallocate(p); }
+void operator delete[](void* p) noexcept { Profiling::Detail::deallocate(p); }
+void operator delete(void* p, std::size_t) noexcept { Profiling::Detail::deallocate(p); }
+void operator delete[](void* p, std::size_t) noexcept { Profiling::Detail::deallocate(p); }
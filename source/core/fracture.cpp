@@ -0,0 +1,460 @@
+#include "fracture.h"
+
+#include <memory>
+#include <algorithm>
+#include <unordered_map>
+#include <array>
+
+#include "kd-tree.h"
+#include "point-distribution.h"
+
+namespace
+{
+    // Builds the cell of seeds[seed] and intersects source with it. The builder clips in its
+    // own buffers, so the fragment doesn't keep the capacity of a copy of source, which
+    // adds up over many fragments of a big mesh. fragment_index is the profile to record in.
+    void buildFragment(
+        Geometry::CellBuilder& builder, const KdTree<Geometry::Vec3>& seeds, size_t seed,
+        const Geometry::Vec3& min, const Geometry::Vec3& max, const Geometry::Mesh& source,
+        Geometry::VoronoiCell& cell, Geometry::Mesh& fragment, 
+        Profiling::Profiler* profiler, size_t worker, size_t fragment_index)
+    {
+        if (!profiler)
+        {
+            builder.build(seeds, seed, min, max, cell);
+            builder.intersect(source, cell, fragment);
+            return;
+        }
+
+        const Geometry::PlaneTestStats before = builder.stats;
+        const size_t allocations = Profiling::threadAllocations();
+        const double begin = profiler->now();
+
+        builder.build(seeds, seed, min, max, cell);
+        const double built = profiler->now();
+
+        builder.intersect(source, cell, fragment);
+        const double end = profiler->now();
+
+        Profiling::FragmentProfile& profile = profiler->fragments[fragment_index];
+        profile.allocations = Profiling::threadAllocations() - allocations;
+
+        profiler->record("buildCell", worker + 1, begin, built, fragment_index);
+        profiler->record("intersect", worker + 1, built, end, fragment_index);
+
+        profile.build = built - begin;
+        profile.intersect = end - built;
+        profile.worker = worker;
+        profile.planes = builder.stats - before;
+    }
+
+    // Shared by fractureMesh and fractureLevel, cells are kept if kept_cells is given
+    std::vector<Geometry::Mesh> fractureCells(
+        const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds,
+        const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+        Geometry::PlaneTestStats* stats, Profiling::Profiler* profiler,
+        std::vector<Geometry::VoronoiCell>* kept_cells)
+    {
+        const double index_begin = profiler ? profiler->now() : 0.0;
+        const KdTree<Geometry::Vec3> seed_index(seeds);
+        if (profiler) profiler->record("seedIndex", 0, index_begin, profiler->now());
+
+        // Scratch data is per worker, fragments are only written by the task that owns them
+        std::vector<Geometry::CellBuilder> builders(pool.size());
+        std::vector<Geometry::VoronoiCell> cells(pool.size());
+
+        if (kept_cells) kept_cells->assign(seeds.size(), Geometry::VoronoiCell());
+
+        std::vector<Geometry::Mesh> fragments(seeds.size());
+
+        size_t first_profile = 0;
+        if (profiler)
+        {
+            profiler->reserveLanes(pool.size() + 1);
+            first_profile = profiler->addFragments(seeds.size());
+        }
+
+        pool.parallelFor(seeds.size(), [&](size_t i, size_t worker)
+        {
+            auto& cell = kept_cells ? (*kept_cells)[i] : cells[worker];
+            buildFragment(builders[worker], seed_index, i, min, max, source, cell, fragments[i], profiler, worker, first_profile + i);
+        });
+
+        if (stats)
+        {
+            for (const auto& builder : builders) *stats += builder.stats;
+        }
+
+        return fragments;
+    }
+
+    template<class T>
+    std::vector<std::shared_ptr<T>> share(std::vector<T>& values)
+    {
+        std::vector<std::shared_ptr<T>> shared;
+        shared.reserve(values.size());
+        for (T& value : values) shared.push_back(std::make_shared<T>(std::move(value)));
+        return shared;
+    }
+
+    // Entry of a level that can be changed, copied first if another level or holder shares it
+    template<class T>
+    T& writable(std::shared_ptr<T>& entry)
+    {
+        if (entry.use_count() > 1) entry = std::make_shared<T>(*entry);
+        return *entry;
+    }
+
+    // Entry of a level that is rebuilt, a new one if it is missing or shared. Unshared entries
+    // keep the capacity of their buffers.
+    template<class T>
+    T& rebuilt(std::shared_ptr<T>& entry)
+    {
+        if (!entry || entry.use_count() > 1) entry = std::make_shared<T>();
+        return *entry;
+    }
+}
+
+std::vector<Geometry::Mesh> Fracture::fractureMesh(
+    const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds,
+    const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+    Geometry::PlaneTestStats* stats, Profiling::Profiler* profiler)
+{
+    return fractureCells(source, seeds, min, max, pool, stats, profiler, nullptr);
+}
+
+bool Fracture::fractureBatches(
+    const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds,
+    const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+    size_t batch_size, const FragmentSink& sink,
+    Geometry::PlaneTestStats* stats, Profiling::Profiler* profiler)
+{
+    const double index_begin = profiler ? profiler->now() : 0.0;
+    const KdTree<Geometry::Vec3> seed_index(seeds);
+    const std::vector<size_t> order = PointDistribution::spatialOrder(seeds, min, max, PointDistribution::Curve::MORTON);
+    if (profiler) profiler->record("seedIndex", 0, index_begin, profiler->now());
+
+    std::vector<Geometry::CellBuilder> builders(pool.size());
+    std::vector<Geometry::VoronoiCell> cells(pool.size());
+
+    batch_size = std::max(batch_size, (size_t)1);
+    std::vector<Geometry::Mesh> fragments(std::min(batch_size, seeds.size()));
+
+    size_t first_profile = 0;
+    if (profiler)
+    {
+        profiler->reserveLanes(pool.size() + 1);
+        first_profile = profiler->addFragments(seeds.size());
+    }
+
+    bool completed = true;
+    for (size_t begin = 0; begin < seeds.size() && completed; begin += batch_size)
+    {
+        const size_t end = std::min(begin + batch_size, seeds.size());
+
+        pool.parallelFor(end - begin, [&](size_t k, size_t worker)
+        {
+            const size_t i = order[begin + k];
+            buildFragment(builders[worker], seed_index, i, min, max, source, cells[worker], fragments[k], profiler, worker, first_profile + i);
+        });
+
+        Profiling::Profiler::Scope scope(profiler, "writeBatch");
+        for (size_t k = 0; k < end - begin && completed; k++)
+        {
+            if (!fragments[k].empty()) completed = sink(order[begin + k], fragments[k]);
+            fragments[k].clear();
+        }
+    }
+
+    if (stats)
+    {
+        for (const auto& builder : builders) *stats += builder.stats;
+    }
+
+    return completed;
+}
+
+std::vector<Geometry::VoronoiCell> Fracture::buildCells(
+    const std::vector<Geometry::Vec3>& seeds, const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool)
+{
+    const KdTree<Geometry::Vec3> seed_index(seeds);
+
+    std::vector<Geometry::CellBuilder> builders(pool.size());
+    std::vector<Geometry::VoronoiCell> cells(seeds.size());
+
+    pool.parallelFor(seeds.size(), [&](size_t i, size_t worker)
+    {
+        builders[worker].build(seed_index, i, min, max, cells[i]);
+    });
+
+    return cells;
+}
+
+Fracture::Level Fracture::fractureLevel(
+    const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds,
+    const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+    Geometry::PlaneTestStats* stats, Profiling::Profiler* profiler)
+{
+    std::vector<Geometry::VoronoiCell> cells;
+    std::vector<Geometry::Mesh> fragments = fractureCells(source, seeds, min, max, pool, stats, profiler, &cells);
+
+    Level level;
+    level.seeds = seeds;
+    level.fragments = share(fragments);
+    level.cells = share(cells);
+    return level;
+}
+
+Fracture::Level Fracture::subFracture(
+    const Level& parent, size_t num_seeds, uint64_t seed, double min_distance, ThreadPool& pool,
+    Geometry::PlaneTestStats* stats, Profiling::Profiler* profiler)
+{
+    const size_t num_parents = parent.fragments.size();
+
+    // Seeds and their index per parent, fine cells are bounded by the box of the parent cell
+    std::vector<std::vector<Geometry::Vec3>> seeds(num_parents);
+    std::vector<Geometry::Mesh> sources(num_parents);
+    std::vector<std::unique_ptr<KdTree<Geometry::Vec3>>> seed_indices(num_parents);
+    std::vector<Geometry::Bounds> bounds(num_parents);
+
+    const double seeds_begin = profiler ? profiler->now() : 0.0;
+
+    pool.parallelFor(num_parents, [&](size_t i, size_t)
+    {
+        if (parent.fragments[i]->empty()) return;
+
+        const Geometry::VoronoiCell& cell = *parent.cells[i];
+        bounds[i].compute(cell.mesh.vertices);
+
+        seeds[i] = PointDistribution::removeDuplicates(
+            PointDistribution::uniformConvex(cell.planes, bounds[i].min, bounds[i].max, num_seeds, seed, (uint32_t)i),
+            min_distance
+        );
+        seed_indices[i] = std::make_unique<KdTree<Geometry::Vec3>>(seeds[i]);
+
+        // Caps of the parent get negative tags, which tell them apart from fine caps
+        sources[i] = *parent.fragments[i];
+        for (int& tag : sources[i].polygon_tags)
+        {
+            if (tag >= 0) tag = -2 - tag;
+        }
+    });
+
+    if (profiler) profiler->record("subSeeds", 0, seeds_begin, profiler->now());
+
+    // offsets[i] is the first fine fragment of parent i
+    std::vector<size_t> offsets(1, 0);
+    for (const auto& s : seeds) offsets.push_back(offsets.back() + s.size());
+
+    Level level;
+    level.seeds.reserve(offsets.back());
+    level.parents.reserve(offsets.back());
+    for (size_t i = 0; i < num_parents; i++)
+    {
+        level.seeds.insert(level.seeds.end(), seeds[i].begin(), seeds[i].end());
+        level.parents.insert(level.parents.end(), seeds[i].size(), i);
+    }
+
+    std::vector<Geometry::CellBuilder> builders(pool.size());
+    std::vector<Geometry::VoronoiCell> cells(pool.size());
+
+    std::vector<Geometry::Mesh> fragments(offsets.back());
+    std::vector<Geometry::VoronoiCell> fine_cells(offsets.back());
+
+    size_t first_profile = 0;
+    if (profiler)
+    {
+        profiler->reserveLanes(pool.size() + 1);
+        first_profile = profiler->addFragments(offsets.back());
+    }
+
+    pool.parallelFor(offsets.back(), [&](size_t k, size_t worker)
+    {
+        const size_t i = level.parents[k];
+        buildFragment(builders[worker], *seed_indices[i], k - offsets[i], bounds[i].min, bounds[i].max,
+            sources[i], cells[worker], fragments[k], profiler, worker, first_profile + k);
+
+        // Fine seeds are numbered within their parent while the cell is built
+        for (int& tag : fragments[k].polygon_tags)
+        {
+            if (tag >= 0) tag += (int)offsets[i];
+        }
+
+        Geometry::VoronoiCell& cell = fine_cells[k];
+        cell.planes = cells[worker].planes;
+        cell.neighbours = cells[worker].neighbours;
+        for (int& neighbour : cell.neighbours) neighbour += (int)offsets[i];
+    });
+
+    if (stats)
+    {
+        for (const auto& builder : builders) *stats += builder.stats;
+    }
+
+    level.fragments = share(fragments);
+    level.cells = share(fine_cells);
+    return level;
+}
+
+size_t Fracture::refracture(
+    Level& level, const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds,
+    const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+    Geometry::PlaneTestStats* stats, Profiling::Profiler* profiler)
+{
+    struct SeedHash
+    {
+        size_t operator()(const Geometry::Vec3& p) const
+        {
+            const std::hash<double> h;
+            return h(p.x) ^ (h(p.y) * 31) ^ (h(p.z) * 961);
+        }
+    };
+    struct SeedEqual
+    {
+        bool operator()(const Geometry::Vec3& a, const Geometry::Vec3& b) const { return a.x == b.x && a.y == b.y && a.z == b.z; }
+    };
+
+    // Old index of every seed, or NONE for added seeds
+    constexpr size_t NONE = ~(size_t)0;
+
+    std::unordered_map<Geometry::Vec3, size_t, SeedHash, SeedEqual> old_indices;
+    for (size_t i = 0; i < level.seeds.size(); i++) old_indices.emplace(level.seeds[i], i);
+
+    std::vector<size_t> old_of(seeds.size(), NONE);
+    std::vector<size_t> new_of(level.seeds.size(), NONE);
+    for (size_t j = 0; j < seeds.size(); j++)
+    {
+        auto it = old_indices.find(seeds[j]);
+        if (it == old_indices.end() || new_of[it->second] != NONE) continue;
+
+        old_of[j] = it->second;
+        new_of[it->second] = j;
+    }
+
+    // Kept cells and fragments move to their new index, cap tags are seed indices. Shared
+    // entries are replaced instead of changed, so other holders keep them as they were.
+    Level updated;
+    updated.seeds = seeds;
+    updated.cells.resize(seeds.size());
+    updated.fragments.resize(seeds.size());
+
+    std::vector<char> dirty(seeds.size(), 0);
+    for (size_t j = 0; j < seeds.size(); j++)
+    {
+        if (old_of[j] == NONE)
+        {
+            dirty[j] = 1;
+            continue;
+        }
+
+        updated.cells[j] = std::move(level.cells[old_of[j]]);
+        updated.fragments[j] = std::move(level.fragments[old_of[j]]);
+    }
+
+    for (size_t i = 0; i < level.seeds.size(); i++)
+    {
+        if (new_of[i] != NONE) continue;
+        for (int n : level.cells[i]->neighbours)
+        {
+            if (new_of[n] != NONE) dirty[new_of[n]] = 1;
+        }
+    }
+
+    pool.parallelFor(seeds.size(), [&](size_t j, size_t)
+    {
+        if (dirty[j]) return;
+
+        // Entries whose neighbours keep their index are left alone
+        auto renumbered = [&](const std::vector<int>& tags)
+        {
+            return std::any_of(tags.begin(), tags.end(), [&](int tag) { return tag >= 0 && new_of[tag] != (size_t)tag; });
+        };
+        auto remap = [&](std::vector<int>& tags)
+        {
+            for (int& tag : tags)
+            {
+                if (tag >= 0) tag = (int)new_of[tag];
+            }
+        };
+
+        const Geometry::VoronoiCell& cell = *updated.cells[j];
+        if (renumbered(cell.neighbours) || renumbered(cell.mesh.polygon_tags))
+        {
+            Geometry::VoronoiCell& copy = writable(updated.cells[j]);
+            remap(copy.neighbours);
+            remap(copy.mesh.polygon_tags);
+        }
+        if (renumbered(updated.fragments[j]->polygon_tags)) remap(writable(updated.fragments[j]).polygon_tags);
+    });
+
+    const double index_begin = profiler ? profiler->now() : 0.0;
+    const KdTree<Geometry::Vec3> seed_index(updated.seeds);
+    if (profiler) profiler->record("seedIndex", 0, index_begin, profiler->now());
+
+    std::vector<Geometry::CellBuilder> builders(pool.size());
+
+    size_t first_profile = 0;
+    if (profiler)
+    {
+        profiler->reserveLanes(pool.size() + 1);
+        first_profile = profiler->addFragments(seeds.size());
+    }
+
+    auto rebuild = [&](const std::vector<size_t>& indices)
+    {
+        pool.parallelFor(indices.size(), [&](size_t k, size_t worker)
+        {
+            const size_t j = indices[k];
+            buildFragment(builders[worker], seed_index, j, min, max, source,
+                rebuilt(updated.cells[j]), rebuilt(updated.fragments[j]), profiler, worker, first_profile + j);
+        });
+    };
+
+    // Added seeds first, their cells tell which kept cells they cut into
+    std::vector<size_t> added, affected;
+    for (size_t j = 0; j < seeds.size(); j++)
+    {
+        if (old_of[j] == NONE) added.push_back(j);
+    }
+    rebuild(added);
+
+    for (size_t j : added)
+    {
+        for (int n : updated.cells[j]->neighbours) dirty[n] = 1;
+    }
+    for (size_t j = 0; j < seeds.size(); j++)
+    {
+        if (dirty[j] && old_of[j] != NONE) affected.push_back(j);
+    }
+    rebuild(affected);
+
+    if (stats)
+    {
+        for (const auto& builder : builders) *stats += builder.stats;
+    }
+
+    level = std::move(updated);
+
+    return added.size() + affected.size();
+}
+
+uint64_t Fracture::hashInputs(const Geometry::Mesh& source, const Geometry::Vec3& min, const Geometry::Vec3& max)
+{
+    // 64 bit FNV-1a over the raw bytes, the inputs are compared bit for bit anyway
+    uint64_t hash = 0xCBF29CE484222325;
+    auto add = [&](const void* data, size_t size)
+    {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * 0x100000001B3;
+    };
+
+    const size_t sizes[] = { source.vertices.size(), source.polygon_counts.size(), source.polygon_connects.size() };
+    add(sizes, sizeof(sizes));
+    add(source.vertices.data(), source.vertices.size() * sizeof(Geometry::Vec3));
+    add(source.polygon_counts.data(), source.polygon_counts.size() * sizeof(int));
+    add(source.polygon_connects.data(), source.polygon_connects.size() * sizeof(int));
+    add(&min, sizeof(min));
+    add(&max, sizeof(max));
+
+    return hash;
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+#include "geometry.h"
+#include "thread-pool.h"
+#include "vertex-buffer.h"
+#include "voronoi-cell.h"
+#include "profiler.h"
+
+namespace Fracture
+{
+    // Intersects source with the Voronoi cell of every seed, where cells are bounded by the
+    // box [min, max]. Cells are computed in parallel and fragments of seeds whose cell 
+    // doesn't intersect the mesh are left empty. With a profiler, the seed index, every cell
+    // and every intersection are timed and plane work is recorded per fragment, after the
+    // fragments the profiler already holds.
+    std::vector<Geometry::Mesh> fractureMesh(
+        const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds, 
+        const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+        Geometry::PlaneTestStats* stats = nullptr, Profiling::Profiler* profiler = nullptr
+    );
+
+    // Called with the seed index and fragment, which may be moved from. Returning false stops.
+    using FragmentSink = std::function<bool(size_t, Geometry::Mesh&)>;
+
+    // Same as fractureMesh, but seeds are processed in batches of batch_size spatially close
+    // seeds and every non-empty fragment is passed to sink on the calling thread as soon as
+    // its batch is done. Only one batch of fragments is alive at a time, so peak memory is
+    // bounded by the batch size instead of the number of seeds. Returns false if sink stopped.
+    bool fractureBatches(
+        const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds,
+        const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+        size_t batch_size, const FragmentSink& sink,
+        Geometry::PlaneTestStats* stats = nullptr, Profiling::Profiler* profiler = nullptr
+    );
+
+    // Only the Voronoi cells of the seeds bounded by [min, max], without intersecting a mesh.
+    // Cheap enough for interactive previews, cells are built in parallel.
+    std::vector<Geometry::VoronoiCell> buildCells(
+        const std::vector<Geometry::Vec3>& seeds, const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool
+    );
+
+    // One level of a hierarchical fracture. The coarse level keeps its cells so finer levels
+    // can restrict their seeds to them and be recomputed without touching the coarse one.
+    // Fragments and cells are shared per seed, so copies of a level and holders of single
+    // fragments share the unchanged ones. Shared entries are never written, refracture
+    // replaces the entries it rebuilds or renumbers and only copies those.
+    struct Level
+    {
+        std::vector<Geometry::Vec3> seeds;
+        std::vector<std::shared_ptr<Geometry::Mesh>> fragments;
+
+        // Cells of the seeds, kept by fractureLevel. subFracture keeps only their planes and
+        // neighbours, which the contacts between fine fragments need.
+        std::vector<std::shared_ptr<Geometry::VoronoiCell>> cells;
+
+        // Index of the parent fragment of every fragment, only set by subFracture
+        std::vector<size_t> parents;
+    };
+
+    // Same as fractureMesh, keeping the cells for subFracture
+    Level fractureLevel(
+        const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds,
+        const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+        Geometry::PlaneTestStats* stats = nullptr, Profiling::Profiler* profiler = nullptr
+    );
+
+    // Splits every non-empty fragment of parent into up to num_seeds pieces, with seeds drawn
+    // uniformly inside its cell and closer seeds than min_distance removed. Seeds of a cell
+    // only compete with each other, so all fine cells of all parents are built in parallel.
+    // Fragments are ordered by parent, the profiler records them like fractureMesh does.
+    // Caps between fine fragments are tagged with the fine index, caps on a face of the parent
+    // with -2 minus the index of the parent's neighbour.
+    Level subFracture(
+        const Level& parent, size_t num_seeds, uint64_t seed, double min_distance, ThreadPool& pool,
+        Geometry::PlaneTestStats* stats = nullptr, Profiling::Profiler* profiler = nullptr
+    );
+
+    // Updates level, computed by fractureLevel for the same source and box, to the cells of
+    // seeds. Seeds that are bit-identical to old ones keep their cell and fragment unless its
+    // neighbourhood changed, which only happens for new neighbours of added seeds and old
+    // neighbours of removed ones. Moved seeds count as removed and added. Returns the number
+    // of cells rebuilt, the profiler only records those.
+    size_t refracture(
+        Level& level, const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds,
+        const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool,
+        Geometry::PlaneTestStats* stats = nullptr, Profiling::Profiler* profiler = nullptr
+    );
+
+    // Hash of the inputs a level depends on besides its seeds, to tell when it can be reused
+    uint64_t hashInputs(const Geometry::Mesh& source, const Geometry::Vec3& min, const Geometry::Vec3& max);
+}
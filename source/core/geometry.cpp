@@ -0,0 +1,172 @@
+#include "geometry.h"
+#include "predicates.h"
+
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include <cstdint>
+
+bool Geometry::Plane::intersects(const Mesh& mesh, bool& strictly_greater) const
+{
+    bool greater = false, less = false;
+    strictly_greater = false;
+    for (const auto& v : mesh.vertices)
+    {
+        if (side(v) > 0)
+            greater = true;
+        else
+            less = true;
+
+        if (greater && less) return true;
+    }
+    strictly_greater = greater && !less;
+    return false;
+}
+
+int Geometry::Plane::exactSide(const Vec3& x) const
+{
+    if (int s = Predicates::bisector(p0, p1, x)) return s;
+
+    // Symbolic perturbation, as if the lexicographically smaller seed were infinitesimally
+    // closer. Unlike indices, coordinates don't change when seeds are added or removed.
+    const bool p0_first = p0.x != p1.x ? p0.x < p1.x : p0.y != p1.y ? p0.y < p1.y : p0.z != p1.z ? p0.z < p1.z : i0 < i1;
+    return p0_first ? -1 : 1;
+}
+
+Geometry::Plane Geometry::getBisectorPlane(const Vec3& p0, const Vec3& p1, int i0, int i1)
+{
+    Plane plane(p1 - p0, (p0 + p1) * 0.5);
+    plane.p0 = p0;
+    plane.p1 = p1;
+    plane.i0 = i0;
+    plane.i1 = i1;
+    return plane;
+}
+
+
+Geometry::Mesh Geometry::boxMesh(const Vec3& min, const Vec3& max)
+{
+    Mesh mesh;
+    boxMesh(min, max, mesh);
+    return mesh;
+}
+
+void Geometry::boxMesh(const Vec3& min, const Vec3& max, Mesh& mesh)
+{
+    mesh.vertices.clear();
+    for (int i = 0; i < 8; i++)
+    {
+        mesh.vertices.emplace_back(i & 1 ? max.x : min.x, i & 2 ? max.y : min.y, i & 4 ? max.z : min.z);
+    }
+
+    // Counter-clockwise seen from the outside
+    constexpr int indices[] = { 0, 2, 3, 1, /**/ 4, 5, 7, 6, /**/ 0, 1, 5, 4, /**/ 2, 6, 7, 3, /**/ 0, 4, 6, 2, /**/ 1, 3, 7, 5 };
+
+    mesh.polygon_counts.assign(6, 4);
+    mesh.polygon_connects.assign(std::begin(indices), std::end(indices));
+    mesh.polygon_tags.assign(6, -1);
+}
+
+Geometry::Mesh Geometry::sphereMesh(size_t rings, size_t segments, double radius, const std::function<double(double, double)>& displacement)
+{
+    Mesh mesh;
+
+    // Poles are single vertices, rings in between
+    mesh.vertices.push_back(Vec3(0, 0, radius));
+    for (size_t i = 1; i < rings; i++)
+    {
+        const double theta = M_PI * i / rings;
+        for (size_t j = 0; j < segments; j++)
+        {
+            const double phi = 2.0 * M_PI * j / segments;
+            const double r = displacement ? radius * displacement(theta, phi) : radius;
+            mesh.vertices.push_back(Vec3(r * std::sin(theta) * std::cos(phi), r * std::sin(theta) * std::sin(phi), r * std::cos(theta)));
+        }
+    }
+    mesh.vertices.push_back(Vec3(0, 0, -radius));
+
+    auto ring = [segments](size_t i, size_t j) { return (int)(1 + (i - 1) * segments + j % segments); };
+    auto triangle = [&mesh](int a, int b, int c)
+    {
+        mesh.polygon_counts.push_back(3);
+        mesh.polygon_connects.insert(mesh.polygon_connects.end(), { a, b, c });
+        mesh.polygon_tags.push_back(-1);
+    };
+
+    const int south = (int)mesh.vertices.size() - 1;
+    for (size_t j = 0; j < segments; j++)
+    {
+        triangle(0, ring(1, j), ring(1, j + 1));
+        for (size_t i = 1; i + 1 < rings; i++)
+        {
+            triangle(ring(i, j), ring(i + 1, j), ring(i + 1, j + 1));
+            triangle(ring(i, j), ring(i + 1, j + 1), ring(i, j + 1));
+        }
+        triangle(ring(rings - 1, j), south, ring(rings - 1, j + 1));
+    }
+
+    return mesh;
+}
+
+Geometry::Mesh Geometry::torusMesh(size_t rings, size_t segments, double R, double r)
+{
+    Mesh mesh;
+
+    for (size_t i = 0; i < rings; i++)
+    {
+        const double u = 2.0 * M_PI * i / rings;
+        for (size_t j = 0; j < segments; j++)
+        {
+            const double v = 2.0 * M_PI * j / segments;
+            mesh.vertices.push_back(Vec3((R + r * std::cos(v)) * std::cos(u), (R + r * std::cos(v)) * std::sin(u), r * std::sin(v)));
+        }
+    }
+
+    auto idx = [rings, segments](size_t i, size_t j) { return (int)((i % rings) * segments + j % segments); };
+    for (size_t i = 0; i < rings; i++)
+    {
+        for (size_t j = 0; j < segments; j++)
+        {
+            mesh.polygon_counts.push_back(4);
+            mesh.polygon_connects.insert(mesh.polygon_connects.end(), { idx(i, j), idx(i + 1, j), idx(i + 1, j + 1), idx(i, j + 1) });
+            mesh.polygon_tags.push_back(-1);
+        }
+    }
+
+    return mesh;
+}
+
+double Geometry::maxSquaredDistance(const Mesh& mesh, const Vec3& p)
+{
+    double max_distance = 0.0;
+    for (const auto& v : mesh.vertices)
+    {
+        Vec3 d = v - p;
+        max_distance = std::max(max_distance, d * d);
+    }
+    return max_distance;
+}
+
+bool Geometry::isClosed(const Mesh& mesh)
+{
+    // +1 per directed edge and -1 per reversed one, so all counts of a closed mesh cancel out
+    std::unordered_map<uint64_t, int> edges;
+    edges.reserve(mesh.polygon_connects.size());
+
+    size_t offset = 0;
+    for (int count : mesh.polygon_counts)
+    {
+        for (int j = 0; j < count; j++)
+        {
+            uint32_t a = mesh.polygon_connects[offset + j];
+            uint32_t b = mesh.polygon_connects[offset + (j + 1) % count];
+            if (a < b)
+                edges[(uint64_t)a << 32 | b]++;
+            else
+                edges[(uint64_t)b << 32 | a]--;
+        }
+        offset += count;
+    }
+
+    return std::all_of(edges.begin(), edges.end(), [](const auto& edge) { return edge.second == 0; });
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <functional>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// Maya independent geometry types used by the fracture kernels
+namespace Geometry
+{
+    struct Vec3
+    {
+        Vec3() = default;
+        Vec3(double x, double y, double z) : x(x), y(y), z(z) { }
+
+        Vec3 operator+(const Vec3& v) const { return Vec3(x + v.x, y + v.y, z + v.z); }
+        Vec3 operator-(const Vec3& v) const { return Vec3(x - v.x, y - v.y, z - v.z); }
+        Vec3 operator-() const { return Vec3(-x, -y, -z); }
+        Vec3 operator*(double s) const { return Vec3(x * s, y * s, z * s); }
+        Vec3 operator/(double s) const { return Vec3(x / s, y / s, z / s); }
+
+        // Dot and cross product, same operators as MVector
+        double operator*(const Vec3& v) const { return x * v.x + y * v.y + z * v.z; }
+        Vec3 operator^(const Vec3& v) const { return Vec3(y * v.z - z * v.y, z * v.x - x * v.z, x * v.y - y * v.x); }
+
+        Vec3& operator+=(const Vec3& v) { x += v.x; y += v.y; z += v.z; return *this; }
+        Vec3& operator-=(const Vec3& v) { x -= v.x; y -= v.y; z -= v.z; return *this; }
+        Vec3& operator*=(double s) { x *= s; y *= s; z *= s; return *this; }
+
+        double length() const { return std::sqrt(x * x + y * y + z * z); }
+        double maxAbs() const { return std::max(std::abs(x), std::max(std::abs(y), std::abs(z))); }
+        Vec3 normal() const { return *this / length(); }
+
+        double x = 0.0, y = 0.0, z = 0.0;
+    };
+
+    inline Vec3 operator*(double s, const Vec3& v) { return v * s; }
+
+    // Indexed polygon mesh using the same layout as MFnMesh::create. Each polygon also 
+    // carries a tag, -1 for original polygons and the plane id for clipping caps.
+    struct Mesh
+    {
+        void clear()
+        {
+            vertices.clear();
+            polygon_counts.clear();
+            polygon_connects.clear();
+            polygon_tags.clear();
+        }
+
+        bool empty() const { return polygon_counts.empty(); }
+
+        // Releases unused capacity, e.g. of a fragment clipped from a copy of a large mesh
+        void shrinkToFit()
+        {
+            vertices.shrink_to_fit();
+            polygon_counts.shrink_to_fit();
+            polygon_connects.shrink_to_fit();
+            polygon_tags.shrink_to_fit();
+        }
+
+        std::vector<Vec3> vertices;
+        std::vector<int> polygon_counts;
+        std::vector<int> polygon_connects;
+        std::vector<int> polygon_tags;
+    };
+
+    struct Plane
+    {
+        Plane(const Vec3& n, const Vec3& p) : normal(n.normal()), point(p) { }
+
+        double signedDistance(const Vec3& x) const { return normal * (x - point); }
+
+        // 1 if x is above the plane, -1 otherwise. Bisector planes classify exactly: within
+        // the rounding error of signedDistance the side is decided from the seeds, and points
+        // equidistant to both seeds go to the lexicographically smaller seed, or to the lower
+        // index if the seeds coincide.
+        int side(const Vec3& x) const { return side(x, signedDistance(x)); }
+
+        // Same as side(x) with distance = signedDistance(x) already computed
+        int side(const Vec3& x, double distance) const
+        {
+            if (i0 < 0) return distance > 0.0 ? 1 : -1;
+
+            const double bound = errorBound(x.maxAbs());
+            if (distance > bound) return 1;
+            if (distance < -bound) return -1;
+
+            return exactSide(x);
+        }
+
+        // Side of x decided from the seeds of a bisector plane alone
+        int exactSide(const Vec3& x) const;
+
+        // Bound on the rounding error of signedDistance for points with coordinates of at
+        // most magnitude, 0 for planes that aren't bisectors and don't need exact tests
+        double errorBound(double magnitude) const
+        {
+            // Normalizing the normal, rounding the midpoint and the dot product each contribute
+            // a few roundings of the largest coordinate. 64 of them leave ample margin.
+            constexpr double ERROR = 64.0 * std::numeric_limits<double>::epsilon();
+            return i0 < 0 ? 0.0 : ERROR * (magnitude + std::max(p0.maxAbs(), p1.maxAbs()));
+        }
+
+        bool intersects(const Mesh& mesh, bool& strictly_greater) const;
+
+        Vec3 normal, point;
+
+        // Seeds of a bisector plane and their indices, -1 for other planes
+        Vec3 p0, p1;
+        int i0 = -1, i1 = -1;
+    };
+
+    // Plane between p0 and p1 with the normal towards p1. The seed indices decide the side
+    // of points on the plane if the seeds coincide.
+    Plane getBisectorPlane(const Vec3& p0, const Vec3& p1, int i0 = 0, int i1 = 1);
+
+    Mesh boxMesh(const Vec3& min, const Vec3& max);
+
+    // Same, overwriting mesh without giving up its buffers
+    void boxMesh(const Vec3& min, const Vec3& max, Mesh& mesh);
+
+    // Closed triangulated sphere around the origin. The radius can be scaled per direction by
+    // displacement(theta, phi), e.g. for bumpy test objects.
+    Mesh sphereMesh(size_t rings, size_t segments, double radius, const std::function<double(double, double)>& displacement = nullptr);
+
+    // Closed quad torus around the z axis
+    Mesh torusMesh(size_t rings, size_t segments, double R, double r);
+
+    double maxSquaredDistance(const Mesh& mesh, const Vec3& p);
+
+    // True if every edge is used as often in both directions, which holds for watertight
+    // and consistently oriented meshes
+    bool isClosed(const Mesh& mesh);
+}
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <functional>
+
+// k-d tree over a fixed point set, Point only needs x, y and z members. 
+// Neighbours are found lazily in increasing distance order with best-first search,
+// so callers can stop as soon as they know no further neighbour is relevant.
+template<class Point>
+class KdTree
+{
+public:
+    explicit KdTree(const std::vector<Point>& points) : source_points(points)
+    {
+        indices.resize(points.size());
+        std::iota(indices.begin(), indices.end(), 0);
+
+        coords.resize(points.size());
+        if (!points.empty()) build(0, (unsigned)points.size());
+
+        for (size_t i = 0; i < indices.size(); i++)
+        {
+            const Point& p = points[indices[i]];
+            coords[i] = { p.x, p.y, p.z };
+        }
+    }
+
+    const std::vector<Point>& points() const { return source_points; }
+
+    size_t size() const { return source_points.size(); }
+
+    class Query
+    {
+    public:
+        void reset(const KdTree& tree, const Point& p)
+        {
+            this->tree = &tree;
+            position = { p.x, p.y, p.z };
+            heap.clear();
+            if (!tree.nodes.empty()) push(0.0, 0);
+        }
+
+        // Returns false when all points have been visited
+        bool next(size_t& index, double& distance2)
+        {
+            while (!heap.empty())
+            {
+                std::pop_heap(heap.begin(), heap.end(), std::greater<>());
+                auto [d2, item] = heap.back();
+                heap.pop_back();
+
+                // Negative items are points, positive are nodes
+                if (item < 0)
+                {
+                    index = tree->indices[~item];
+                    distance2 = d2;
+                    return true;
+                }
+
+                const Node& node = tree->nodes[item];
+                if (node.left < 0)
+                {
+                    for (unsigned i = node.begin; i < node.end; i++)
+                    {
+                        const auto& c = tree->coords[i];
+                        double dx = c[0] - position[0], dy = c[1] - position[1], dz = c[2] - position[2];
+                        push(dx * dx + dy * dy + dz * dz, ~(int)i);
+                    }
+                }
+                else
+                {
+                    push(tree->nodes[node.left].distance2(position), node.left);
+                    push(tree->nodes[node.right].distance2(position), node.right);
+                }
+            }
+            return false;
+        }
+
+    private:
+        void push(double d2, int item)
+        {
+            heap.emplace_back(d2, item);
+            std::push_heap(heap.begin(), heap.end(), std::greater<>());
+        }
+
+        const KdTree* tree = nullptr;
+        std::array<double, 3> position;
+        std::vector<std::pair<double, int>> heap;
+    };
+
+private:
+    static constexpr unsigned LEAF_SIZE = 8;
+
+    struct Node
+    {
+        // Squared distance from p to the node bounds
+        double distance2(const std::array<double, 3>& p) const
+        {
+            double d2 = 0.0;
+            for (int a = 0; a < 3; a++)
+            {
+                double d = std::max({ min[a] - p[a], 0.0, p[a] - max[a] });
+                d2 += d * d;
+            }
+            return d2;
+        }
+
+        std::array<double, 3> min, max;
+        unsigned begin, end;
+        int left = -1, right = -1;
+    };
+
+    static double coordinate(const Point& p, int axis)
+    {
+        return axis == 0 ? p.x : (axis == 1 ? p.y : p.z);
+    }
+
+    int build(unsigned begin, unsigned end)
+    {
+        int idx = (int)nodes.size();
+        nodes.emplace_back();
+
+        Node node;
+        node.begin = begin;
+        node.end = end;
+        node.min = { coordinate(source_points[indices[begin]], 0), coordinate(source_points[indices[begin]], 1), coordinate(source_points[indices[begin]], 2) };
+        node.max = node.min;
+        for (unsigned i = begin; i < end; i++)
+        {
+            for (int a = 0; a < 3; a++)
+            {
+                double c = coordinate(source_points[indices[i]], a);
+                node.min[a] = std::min(node.min[a], c);
+                node.max[a] = std::max(node.max[a], c);
+            }
+        }
+
+        if (end - begin > LEAF_SIZE)
+        {
+            // Split at the median of the widest axis
+            int axis = 0;
+            for (int a = 1; a < 3; a++)
+            {
+                if (node.max[a] - node.min[a] > node.max[axis] - node.min[axis]) axis = a;
+            }
+
+            unsigned mid = begin + (end - begin) / 2;
+            std::nth_element(indices.begin() + begin, indices.begin() + mid, indices.begin() + end,
+                [this, axis](size_t a, size_t b)
+                {
+                    return coordinate(source_points[a], axis) < coordinate(source_points[b], axis);
+                }
+            );
+
+            node.left = build(begin, mid);
+            node.right = build(mid, end);
+        }
+
+        nodes[idx] = node;
+        return idx;
+    }
+
+    const std::vector<Point>& source_points;
+    std::vector<size_t> indices;
+    std::vector<std::array<double, 3>> coords;
+    std::vector<Node> nodes;
+};
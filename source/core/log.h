@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <sstream>
+#include <vector>
+#include <mutex>
+#include <functional>
+
+namespace Log
+{
+    enum class Level { ERROR = 0, WARNING = 1, INFO = 2, DEBUG = 3 };
+
+    // Buffers messages at or below a verbosity level and hands them to a sink on flush,
+    // one call per level, so hot loops never wait on the output. Safe to write from workers.
+    class Logger
+    {
+    public:
+        using Sink = std::function<void(Level, const std::string&)>;
+
+        Logger(Level level, Sink sink) : level(level), sink(std::move(sink)) { }
+        ~Logger() { flush(); }
+
+        bool enabled(Level l) const { return l <= level; }
+
+        void write(Level l, std::string message)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            messages.push_back({ l, std::move(message) });
+        }
+
+        // Messages of the same level are joined by newlines, in the order they were written
+        void flush()
+        {
+            std::vector<Message> pending;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                pending.swap(messages);
+            }
+
+            for (Level l : { Level::ERROR, Level::WARNING, Level::INFO, Level::DEBUG })
+            {
+                std::string joined;
+                for (const auto& m : pending)
+                {
+                    if (m.level != l) continue;
+                    if (!joined.empty()) joined += '\n';
+                    joined += m.text;
+                }
+                if (!joined.empty() && sink) sink(l, joined);
+            }
+        }
+
+    private:
+        struct Message
+        {
+            Level level;
+            std::string text;
+        };
+
+        const Level level;
+        Sink sink;
+
+        std::mutex mutex;
+        std::vector<Message> messages;
+    };
+}
+
+// Streams the arguments into a message, which are not evaluated unless the level is enabled:
+// LOG(logger, Log::Level::DEBUG, "Fragment " << i << " has " << n << " faces");
+#define LOG(logger, level, stream)                          \
+    do                                                      \
+    {                                                       \
+        if ((logger).enabled(level))                        \
+        {                                                   \
+            std::ostringstream log_stream_;                 \
+            log_stream_ << stream;                          \
+            (logger).write(level, log_stream_.str());       \
+        }                                                   \
+    } while (0)
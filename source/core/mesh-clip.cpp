@@ -0,0 +1,239 @@
+#include "mesh-clip.h"
+
+#include <algorithm>
+
+bool Geometry::MeshClipper::clipAndCap(Mesh& mesh, const Plane& plane, int tag)
+{
+    const size_t num_vertices = mesh.vertices.size();
+
+    distances.resize(num_vertices);
+    inside.resize(num_vertices);
+
+    // The side is exact, distances are only used to place new vertices on cut edges
+    bool greater = false, less = false;
+    for (size_t i = 0; i < num_vertices; i++)
+    {
+        distances[i] = plane.signedDistance(mesh.vertices[i]);
+        inside[i] = plane.side(mesh.vertices[i], distances[i]) < 0;
+        if (!inside[i])
+            greater = true;
+        else
+            less = true;
+    }
+
+    if (!greater) return false;
+
+    if (!less)
+    {
+        mesh.clear();
+        return true;
+    }
+
+    result.clear();
+    edge_heads.assign(num_vertices, -1);
+    edge_vertices.clear();
+    cap_edges.clear();
+
+    // Kept vertices are placed first, vertices created on cut edges are appended
+    vertex_map.assign(num_vertices, -1);
+    for (size_t i = 0; i < num_vertices; i++)
+    {
+        if (inside[i])
+        {
+            vertex_map[i] = (int)result.vertices.size();
+            result.vertices.push_back(mesh.vertices[i]);
+        }
+    }
+
+    auto add = [this](int v)
+    {
+        if (polygon.empty() || polygon.back() != v) polygon.push_back(v);
+    };
+
+    size_t offset = 0;
+    for (size_t f = 0; f < mesh.polygon_counts.size(); f++)
+    {
+        const int count = mesh.polygon_counts[f];
+        const int* indices = &mesh.polygon_connects[offset];
+        offset += count;
+
+        polygon.clear();
+        crossings.clear();
+
+        for (int k = 0; k < count; k++)
+        {
+            int a = indices[k];
+            int b = indices[(k + 1) % count];
+            bool a_inside = inside[a];
+            bool b_inside = inside[b];
+
+            if (a_inside) add(vertex_map[a]);
+
+            if (a_inside != b_inside)
+            {
+                int v = a_inside ? edgeVertex(mesh, a, b) : edgeVertex(mesh, b, a);
+                add(v);
+                crossings.push_back({ v, (int)polygon.size() - 1, a_inside, -1, 0.0 });
+            }
+        }
+
+        while (polygon.size() > 1 && polygon.front() == polygon.back()) polygon.pop_back();
+
+        // A convex polygon crosses twice and stays in one piece. Otherwise the clipped
+        // polygon would bridge the cut between its pieces, outside of the original polygon.
+        if (crossings.size() > 2 && polygon.size() >= 3 && pairCrossings(mesh, indices, count, plane))
+        {
+            const size_t num_crossings = crossings.size();
+            for (auto& crossing : crossings)
+            {
+                if (crossing.position >= (int)polygon.size()) crossing.position = 0;
+            }
+
+            // Each entry starts a run of the clipped polygon up to the following exit, which
+            // continues at the run of its partner entry. Visited entries get partner -2.
+            for (size_t i = 0; i < num_crossings; i++)
+            {
+                if (crossings[i].exit || crossings[i].partner == -2) continue;
+
+                piece.clear();
+                size_t entry = i;
+                do
+                {
+                    crossings[entry].partner = -2;
+                    const Crossing& exit = crossings[(entry + 1) % num_crossings];
+                    for (int k = crossings[entry].position; ; k = (k + 1) % (int)polygon.size())
+                    {
+                        if (piece.empty() || piece.back() != polygon[k]) piece.push_back(polygon[k]);
+                        if (k == exit.position) break;
+                    }
+                    entry = exit.partner;
+                } while (crossings[entry].partner != -2);
+
+                while (piece.size() > 1 && piece.front() == piece.back()) piece.pop_back();
+
+                if (piece.size() >= 3)
+                {
+                    result.polygon_counts.push_back((int)piece.size());
+                    result.polygon_connects.insert(result.polygon_connects.end(), piece.begin(), piece.end());
+                    result.polygon_tags.push_back(mesh.polygon_tags[f]);
+                }
+            }
+
+            for (const auto& exit : crossings)
+            {
+                if (!exit.exit) continue;
+
+                const int entry = crossings[exit.partner].vertex;
+                if (entry != exit.vertex) cap_edges.emplace_back(entry, exit.vertex);
+            }
+            continue;
+        }
+
+        if (polygon.size() >= 3)
+        {
+            result.polygon_counts.push_back((int)polygon.size());
+            result.polygon_connects.insert(result.polygon_connects.end(), polygon.begin(), polygon.end());
+            result.polygon_tags.push_back(mesh.polygon_tags[f]);
+        }
+
+        // The clipped polygon runs along the cut from each exit to the following entry,
+        // the cap must traverse the same edge in the opposite direction.
+        for (size_t i = 0; i < crossings.size(); i++)
+        {
+            const auto& exit = crossings[i];
+            const auto& entry = crossings[(i + 1) % crossings.size()];
+            if (!exit.exit || entry.exit || entry.vertex == exit.vertex) continue;
+
+            cap_edges.emplace_back(entry.vertex, exit.vertex);
+        }
+    }
+
+    // A later edge from the same vertex replaces an earlier one
+    cap_edge_of.assign(result.vertices.size(), -1);
+    for (size_t i = 0; i < cap_edges.size(); i++) cap_edge_of[cap_edges[i].first] = (int)i;
+
+    // Chain cap edges into loops, each closed loop becomes one cap polygon
+    for (const auto& edge : cap_edges)
+    {
+        if (cap_edge_of[edge.first] < 0) continue;
+
+        polygon.clear();
+        int start = edge.first, current = start;
+        do
+        {
+            const int next = cap_edge_of[current];
+            if (next < 0) break;
+
+            polygon.push_back(current);
+            cap_edge_of[current] = -1;
+            current = cap_edges[next].second;
+        } while (current != start);
+
+        if (current == start && polygon.size() >= 3)
+        {
+            result.polygon_counts.push_back((int)polygon.size());
+            result.polygon_connects.insert(result.polygon_connects.end(), polygon.begin(), polygon.end());
+            result.polygon_tags.push_back(tag);
+        }
+    }
+
+    std::swap(mesh, result);
+
+    return true;
+}
+
+int Geometry::MeshClipper::edgeVertex(const Mesh& mesh, int inside, int outside)
+{
+    // Distances within rounding error may contradict the exact sides, the cut is then at
+    // the inside vertex. Vertices on the plane are reused instead of creating coincident ones.
+    const double d_inside = distances[inside], d_outside = distances[outside];
+    const double t = d_inside < d_outside ? std::min(std::max(d_inside / (d_inside - d_outside), 0.0), 1.0) : 0.0;
+    if (t == 0.0) return vertex_map[inside];
+
+    for (int e = edge_heads[outside]; e >= 0; e = edge_vertices[e].next)
+    {
+        if (edge_vertices[e].inside == inside) return edge_vertices[e].vertex;
+    }
+
+    const Vec3& a = mesh.vertices[inside];
+    const Vec3& b = mesh.vertices[outside];
+
+    int v = (int)result.vertices.size();
+    result.vertices.push_back(a + (b - a) * t);
+
+    edge_vertices.push_back({ inside, v, edge_heads[outside] });
+    edge_heads[outside] = (int)edge_vertices.size() - 1;
+
+    return v;
+}
+
+bool Geometry::MeshClipper::pairCrossings(const Mesh& mesh, const int* indices, int count, const Plane& plane)
+{
+    Vec3 normal(0, 0, 0);
+    for (int k = 0; k < count; k++)
+    {
+        normal = normal + (mesh.vertices[indices[k]] ^ mesh.vertices[indices[(k + 1) % count]]);
+    }
+
+    // Inside the polygon the cut line runs from an exit to an entry, or the other way round
+    // for the parts of the polygon on the removed side
+    const Vec3 direction = plane.normal ^ normal;
+    crossing_order.resize(crossings.size());
+    for (size_t i = 0; i < crossings.size(); i++)
+    {
+        crossings[i].along = direction * result.vertices[crossings[i].vertex];
+        crossing_order[i] = (int)i;
+    }
+    std::sort(crossing_order.begin(), crossing_order.end(), [this](int a, int b) { return crossings[a].along < crossings[b].along; });
+
+    for (size_t i = 0; i + 1 < crossing_order.size(); i += 2)
+    {
+        Crossing& a = crossings[crossing_order[i]];
+        Crossing& b = crossings[crossing_order[i + 1]];
+        if (a.exit == b.exit) return false;
+
+        (a.exit ? a : b).partner = a.exit ? crossing_order[i + 1] : crossing_order[i];
+    }
+
+    return true;
+}
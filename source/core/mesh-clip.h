@@ -0,0 +1,61 @@
+#pragma once
+
+#include <vector>
+
+#include "geometry.h"
+
+namespace Geometry
+{
+    // Clips indexed polygon meshes by a plane, keeping the part on the negative side
+    // and closing each cut loop with a cap polygon. Scratch buffers are kept between
+    // calls and the result is swapped with the mesh, so once the buffers have grown to
+    // the largest mesh clipped, clipping doesn't allocate.
+    class MeshClipper
+    {
+    public:
+        // Returns true if the mesh was modified, an empty mesh means everything was clipped.
+        // Cap polygons are tagged with tag.
+        bool clipAndCap(Mesh& mesh, const Plane& plane, int tag = -1);
+
+    private:
+        int edgeVertex(const Mesh& mesh, int inside, int outside);
+
+        // Pairs the crossings of a non-convex polygon along the cut line, false if the order
+        // along the line doesn't alternate between exits and entries
+        bool pairCrossings(const Mesh& mesh, const int* indices, int count, const Plane& plane);
+
+        Mesh result;
+
+        std::vector<double> distances;
+        std::vector<char> inside;
+        std::vector<int> vertex_map;
+        std::vector<int> polygon, piece;
+
+        // Vertices where a polygon crosses the plane, leaving the kept side at exits, and
+        // their position in the clipped polygon. A polygon that crosses more than twice is
+        // split at the cut, the part after each exit continues at its partner entry.
+        struct Crossing
+        {
+            int vertex, position;
+            bool exit;
+            int partner;
+            double along;
+        };
+        std::vector<Crossing> crossings;
+        std::vector<int> crossing_order;
+
+        // Vertices created on cut edges, listed per outside vertex of the edge. Only the
+        // few edges around an outside vertex share a list, heads are reset per clip.
+        struct EdgeVertex
+        {
+            int inside, vertex, next;
+        };
+        std::vector<int> edge_heads;
+        std::vector<EdgeVertex> edge_vertices;
+
+        // Directed border edges of the cut, from entry to exit vertex, and the edge leaving
+        // each vertex of the result or -1
+        std::vector<std::pair<int, int>> cap_edges;
+        std::vector<int> cap_edge_of;
+    };
+}
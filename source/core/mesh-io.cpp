@@ -0,0 +1,293 @@
+#include "mesh-io.h"
+
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+    std::string extension(const std::string& path)
+    {
+        size_t dot = path.find_last_of('.');
+        if (dot == std::string::npos) return "";
+
+        std::string ext = path.substr(dot + 1);
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return (char)std::tolower(c); });
+        return ext;
+    }
+
+    bool isLittleEndian()
+    {
+        const uint16_t x = 1;
+        return *reinterpret_cast<const uint8_t*>(&x) == 1;
+    }
+
+    struct PlyProperty
+    {
+        std::string name, type, count_type;
+        bool is_list = false;
+    };
+
+    struct PlyElement
+    {
+        std::string name;
+        size_t count = 0;
+        std::vector<PlyProperty> properties;
+    };
+
+    size_t plyTypeSize(const std::string& type)
+    {
+        if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") return 1;
+        if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") return 2;
+        if (type == "int" || type == "uint" || type == "float" || type == "int32" || type == "uint32" || type == "float32") return 4;
+        if (type == "double" || type == "float64") return 8;
+        return 0;
+    }
+
+    // Reads one scalar of the given PLY type as double
+    bool readPlyValue(std::istream& in, const std::string& type, bool ascii, bool swap, double& value)
+    {
+        if (ascii) return (bool)(in >> value);
+
+        size_t size = plyTypeSize(type);
+        if (size == 0) return false;
+
+        unsigned char bytes[8];
+        if (!in.read(reinterpret_cast<char*>(bytes), size)) return false;
+        if (swap) std::reverse(bytes, bytes + size);
+
+        if (type == "char" || type == "int8") { int8_t v; std::memcpy(&v, bytes, 1); value = v; }
+        else if (type == "uchar" || type == "uint8") { uint8_t v; std::memcpy(&v, bytes, 1); value = v; }
+        else if (type == "short" || type == "int16") { int16_t v; std::memcpy(&v, bytes, 2); value = v; }
+        else if (type == "ushort" || type == "uint16") { uint16_t v; std::memcpy(&v, bytes, 2); value = v; }
+        else if (type == "int" || type == "int32") { int32_t v; std::memcpy(&v, bytes, 4); value = v; }
+        else if (type == "uint" || type == "uint32") { uint32_t v; std::memcpy(&v, bytes, 4); value = v; }
+        else if (type == "float" || type == "float32") { float v; std::memcpy(&v, bytes, 4); value = v; }
+        else { double v; std::memcpy(&v, bytes, 8); value = v; }
+
+        return true;
+    }
+
+    template<class T>
+    void writeBinary(std::ostream& out, T value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+}
+
+bool MeshIO::read(const std::string& path, Geometry::Mesh& mesh)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+
+    std::string ext = extension(path);
+    if (ext == "obj") return readObj(in, mesh);
+    if (ext == "ply") return readPly(in, mesh);
+    return false;
+}
+
+bool MeshIO::write(const std::string& path, const Geometry::Mesh& mesh)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out) return false;
+
+    std::string ext = extension(path);
+    if (ext == "obj") return writeObj(out, mesh);
+    if (ext == "ply") return writePly(out, mesh);
+    return false;
+}
+
+bool MeshIO::readObj(std::istream& in, Geometry::Mesh& mesh)
+{
+    mesh.clear();
+
+    std::string line, token;
+    while (std::getline(in, line))
+    {
+        std::istringstream ls(line);
+        if (!(ls >> token)) continue;
+
+        if (token == "v")
+        {
+            Geometry::Vec3 v;
+            if (!(ls >> v.x >> v.y >> v.z)) return false;
+            mesh.vertices.push_back(v);
+        }
+        else if (token == "f")
+        {
+            int count = 0;
+            while (ls >> token)
+            {
+                // v, v/vt, v//vn or v/vt/vn, negative indices are relative to the end
+                int idx = std::stoi(token.substr(0, token.find('/')));
+                idx = idx < 0 ? (int)mesh.vertices.size() + idx : idx - 1;
+                if (idx < 0 || idx >= (int)mesh.vertices.size()) return false;
+
+                mesh.polygon_connects.push_back(idx);
+                count++;
+            }
+            if (count < 3) return false;
+
+            mesh.polygon_counts.push_back(count);
+            mesh.polygon_tags.push_back(-1);
+        }
+    }
+
+    return !mesh.vertices.empty();
+}
+
+bool MeshIO::writeObj(std::ostream& out, const Geometry::Mesh& mesh)
+{
+    out.precision(17);
+
+    for (const auto& v : mesh.vertices)
+    {
+        out << "v " << v.x << ' ' << v.y << ' ' << v.z << '\n';
+    }
+
+    size_t offset = 0;
+    for (int count : mesh.polygon_counts)
+    {
+        out << 'f';
+        for (int k = 0; k < count; k++) out << ' ' << mesh.polygon_connects[offset + k] + 1;
+        out << '\n';
+        offset += count;
+    }
+
+    return (bool)out;
+}
+
+bool MeshIO::readPly(std::istream& in, Geometry::Mesh& mesh)
+{
+    mesh.clear();
+
+    std::string line, token;
+    if (!std::getline(in, line) || line.rfind("ply", 0) != 0) return false;
+
+    bool ascii = false, big_endian = false;
+    std::vector<PlyElement> elements;
+
+    while (std::getline(in, line))
+    {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+
+        std::istringstream ls(line);
+        if (!(ls >> token)) continue;
+
+        if (token == "format")
+        {
+            ls >> token;
+            ascii = token == "ascii";
+            big_endian = token == "binary_big_endian";
+        }
+        else if (token == "element")
+        {
+            PlyElement element;
+            ls >> element.name >> element.count;
+            elements.push_back(element);
+        }
+        else if (token == "property")
+        {
+            if (elements.empty()) return false;
+
+            PlyProperty property;
+            ls >> property.type;
+            if (property.type == "list")
+            {
+                property.is_list = true;
+                ls >> property.count_type >> property.type;
+            }
+            ls >> property.name;
+            elements.back().properties.push_back(property);
+        }
+        else if (token == "end_header")
+        {
+            break;
+        }
+    }
+
+    const bool swap = !ascii && big_endian == isLittleEndian();
+
+    for (const auto& element : elements)
+    {
+        for (size_t e = 0; e < element.count; e++)
+        {
+            Geometry::Vec3 v;
+
+            for (const auto& property : element.properties)
+            {
+                double value;
+                if (!property.is_list)
+                {
+                    if (!readPlyValue(in, property.type, ascii, swap, value)) return false;
+
+                    if (element.name == "vertex")
+                    {
+                        if (property.name == "x") v.x = value;
+                        else if (property.name == "y") v.y = value;
+                        else if (property.name == "z") v.z = value;
+                    }
+                    continue;
+                }
+
+                double count;
+                if (!readPlyValue(in, property.count_type, ascii, swap, count)) return false;
+
+                const bool is_face = element.name == "face" && (property.name == "vertex_indices" || property.name == "vertex_index");
+
+                for (int k = 0; k < (int)count; k++)
+                {
+                    if (!readPlyValue(in, property.type, ascii, swap, value)) return false;
+                    if (is_face) mesh.polygon_connects.push_back((int)value);
+                }
+
+                if (is_face)
+                {
+                    mesh.polygon_counts.push_back((int)count);
+                    mesh.polygon_tags.push_back(-1);
+                }
+            }
+
+            if (element.name == "vertex") mesh.vertices.push_back(v);
+        }
+    }
+
+    for (int idx : mesh.polygon_connects)
+    {
+        if (idx < 0 || idx >= (int)mesh.vertices.size()) return false;
+    }
+
+    return !mesh.vertices.empty();
+}
+
+bool MeshIO::writePly(std::ostream& out, const Geometry::Mesh& mesh)
+{
+    out << "ply\n"
+        << (isLittleEndian() ? "format binary_little_endian 1.0\n" : "format binary_big_endian 1.0\n")
+        << "element vertex " << mesh.vertices.size() << '\n'
+        << "property double x\nproperty double y\nproperty double z\n"
+        << "element face " << mesh.polygon_counts.size() << '\n'
+        << "property list int int vertex_indices\n"
+        << "end_header\n";
+
+    for (const auto& v : mesh.vertices)
+    {
+        writeBinary(out, v.x);
+        writeBinary(out, v.y);
+        writeBinary(out, v.z);
+    }
+
+    size_t offset = 0;
+    for (int count : mesh.polygon_counts)
+    {
+        writeBinary<int32_t>(out, count);
+        for (int k = 0; k < count; k++) writeBinary<int32_t>(out, mesh.polygon_connects[offset + k]);
+        offset += count;
+    }
+
+    return (bool)out;
+}
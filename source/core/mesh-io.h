@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <istream>
+#include <ostream>
+
+#include "geometry.h"
+
+// Reading and writing of polygon meshes as Wavefront OBJ and PLY
+namespace MeshIO
+{
+    // Chooses format from the file extension, returns false if the file can't be read or written
+    bool read(const std::string& path, Geometry::Mesh& mesh);
+    bool write(const std::string& path, const Geometry::Mesh& mesh);
+
+    // Only vertex positions and faces are read, other data is ignored
+    bool readObj(std::istream& in, Geometry::Mesh& mesh);
+    bool writeObj(std::ostream& out, const Geometry::Mesh& mesh);
+
+    // Reads ASCII and binary PLY, writes binary little endian PLY
+    bool readPly(std::istream& in, Geometry::Mesh& mesh);
+    bool writePly(std::ostream& out, const Geometry::Mesh& mesh);
+}
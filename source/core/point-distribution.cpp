@@ -0,0 +1,679 @@
+#include "point-distribution.h"
+
+#include <unordered_map>
+#include <limits>
+#include <cstdint>
+#include <algorithm>
+
+#include "simd-math.h"
+
+using Geometry::Vec3;
+
+namespace
+{
+    constexpr size_t CHUNK_SIZE = 4096;
+
+    // Calls f(begin, end) for chunks of [0, n), in parallel if there is a pool and more than one chunk
+    template<class F>
+    void forChunks(size_t n, ThreadPool* pool, const F& f)
+    {
+        const size_t num_chunks = (n + CHUNK_SIZE - 1) / CHUNK_SIZE;
+        if (!pool || num_chunks < 2)
+        {
+            if (n > 0) f(0, n);
+            return;
+        }
+
+        pool->parallelFor(num_chunks, [&](size_t c, size_t)
+        {
+            f(c * CHUNK_SIZE, std::min(n, (c + 1) * CHUNK_SIZE));
+        });
+    }
+
+    // Samples per block of scratch arrays in the batch samplers
+    constexpr size_t BATCH_SIZE = 256;
+
+    // Sets u[k][j] to the uniform that draw k after Stream::seek(first + j) would return
+    void uniforms(uint64_t seed, uint32_t stream, uint64_t first, size_t n, size_t num_draws, double (*u)[BATCH_SIZE])
+    {
+        size_t j = 0;
+
+#if defined(__AVX2__)
+        // Philox for four samples at a time, with each 32 bit word in the low half of a 64 bit lane
+        const __m256i LOW = _mm256_set1_epi64x(0xFFFFFFFFll);
+        const __m256i M0 = _mm256_set1_epi64x(0xD2511F53), M1 = _mm256_set1_epi64x(0xCD9E8D57);
+        const __m256i ONE = _mm256_set1_epi64x(0x3FF0000000000000ll);
+        const __m256d one = _mm256_set1_pd(1.0);
+
+        auto toUniform = [&](__m256i bits)
+        {
+            return _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(bits, 12), ONE)), one);
+        };
+
+        for (; j + 4 <= n; j += 4)
+        {
+            const __m256i sample = _mm256_add_epi64(_mm256_set1_epi64x((long long)(first + j)), _mm256_setr_epi64x(0, 1, 2, 3));
+
+            for (size_t b = 0; 2 * b < num_draws; b++)
+            {
+                __m256i c0 = _mm256_and_si256(sample, LOW), c1 = _mm256_srli_epi64(sample, 32);
+                __m256i c2 = _mm256_set1_epi64x((long long)b), c3 = _mm256_set1_epi64x(stream);
+                uint32_t k0 = (uint32_t)seed, k1 = (uint32_t)(seed >> 32);
+
+                for (int round = 0; round < 10; round++)
+                {
+                    const __m256i p0 = _mm256_mul_epu32(M0, c0), p1 = _mm256_mul_epu32(M1, c2);
+
+                    c0 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p1, 32), c1), _mm256_set1_epi64x(k0));
+                    c1 = _mm256_and_si256(p1, LOW);
+                    const __m256i n2 = _mm256_xor_si256(_mm256_xor_si256(_mm256_srli_epi64(p0, 32), c3), _mm256_set1_epi64x(k1));
+                    c3 = _mm256_and_si256(p0, LOW);
+                    c2 = n2;
+
+                    k0 += 0x9E3779B9;
+                    k1 += 0xBB67AE85;
+                }
+
+                _mm256_storeu_pd(&u[2 * b][j], toUniform(_mm256_or_si256(_mm256_slli_epi64(c0, 32), c1)));
+                if (2 * b + 1 < num_draws) _mm256_storeu_pd(&u[2 * b + 1][j], toUniform(_mm256_or_si256(_mm256_slli_epi64(c2, 32), c3)));
+            }
+        }
+#endif
+
+        Random::Stream rng(seed, stream);
+        for (; j < n; j++)
+        {
+            rng.seek(first + j);
+            for (size_t k = 0; k < num_draws; k++) u[k][j] = rng.uniform();
+        }
+    }
+
+    void resize(Geometry::VertexBuffer& points, size_t num)
+    {
+        points.x.resize(num);
+        points.y.resize(num);
+        points.z.resize(num);
+    }
+}
+
+std::vector<Geometry::Vec3> PointDistribution::uniformBoundingBox(const Vec3& min, const Vec3& max, size_t num, uint64_t seed, ThreadPool* pool)
+{
+    std::vector<Vec3> points(num);
+
+    forChunks(num, pool, [&](size_t begin, size_t end)
+    {
+        Random::Stream rng(seed, BOUNDING_BOX);
+        for (size_t i = begin; i < end; i++)
+        {
+            rng.seek(i);
+            double x = rng.uniform(min.x, max.x);
+            double y = rng.uniform(min.y, max.y);
+            double z = rng.uniform(min.z, max.z);
+            points[i] = Vec3(x, y, z);
+        }
+    });
+
+    return points;
+}
+
+std::vector<Geometry::Vec3> PointDistribution::sphereQuadratic(const Vec3& position, const std::array<Vec3, 3> &axes, size_t num, uint64_t seed, ThreadPool* pool)
+{
+    std::vector<Vec3> points(num, position);
+
+    forChunks(num, pool, [&](size_t begin, size_t end)
+    {
+        Random::Stream rng(seed, SPHERE);
+        for (size_t i = begin; i < end; i++)
+        {
+            rng.seek(i);
+            double theta = rng.uniform(0.0, M_PI);
+            double phi = rng.uniform(0.0, 2.0 * M_PI);
+            double r = rng.uniform();
+
+            auto& p = points[i];
+            p += std::sin(theta) * std::cos(phi) * axes[0] * r;
+            p += std::sin(theta) * std::sin(phi) * axes[1] * r;
+            p += std::cos(theta) * axes[2] * r;
+        }
+    });
+
+    return points;
+}
+
+std::vector<Geometry::Vec3> PointDistribution::diskQuadratic(const Vec3& position, const std::array<Vec3, 3>& axes, size_t axis, size_t num, uint64_t seed, ThreadPool* pool)
+{
+    unsigned idx = axis - 1;
+    unsigned idx0 = std::min(idx - 1u, 2u); // relies on unsigned wrap-around
+    unsigned idx1 = idx + 1 > 2 ? 0 : idx + 1;
+
+    std::vector<Vec3> points(num, position);
+
+    forChunks(num, pool, [&](size_t begin, size_t end)
+    {
+        Random::Stream rng(seed, DISK);
+        for (size_t i = begin; i < end; i++)
+        {
+            rng.seek(i);
+            double phi = rng.uniform(0.0, 2.0 * M_PI);
+            double r = rng.uniform();
+
+            auto& p = points[i];
+            p += std::cos(phi) * r * axes[idx0];
+            p += std::sin(phi) * r * axes[idx1];
+        }
+    });
+
+    return points;
+}
+
+std::vector<Geometry::Vec3> PointDistribution::diskSteps(const Vec3& position, const std::array<Vec3, 3>& axes, size_t steps, size_t axis, double noise_sigma, size_t num, uint64_t seed, ThreadPool* pool)
+{
+    size_t step_points = num / steps;
+    unsigned idx = axis - 1;
+    unsigned idx0 = std::min(idx - 1u, 2u);
+    unsigned idx1 = idx + 1 > 2 ? 0 : idx + 1;
+
+    std::vector<Vec3> points(step_points * steps, position);
+
+    forChunks(points.size(), pool, [&](size_t begin, size_t end)
+    {
+        Random::Stream rng(seed, DISK_STEPS);
+        for (size_t i = begin; i < end; i++)
+        {
+            const size_t s = i / step_points + 1, sp = i % step_points;
+
+            double r = s / (double)steps;
+            double phi = (sp / (double)step_points) * 2.0 * M_PI;
+
+            rng.seek(i);
+            auto& p = points[i];
+            p += std::cos(phi) * r * rng.normal(1, noise_sigma) * axes[idx0];
+            p += std::sin(phi) * r * rng.normal(1, noise_sigma) * axes[idx1];
+        }
+    });
+
+    return points;
+}
+
+std::vector<Geometry::Vec3> PointDistribution::sphereSteps(const Vec3& position, const std::array<Vec3, 3>& axes, size_t steps, double noise_sigma, size_t num, uint64_t seed, ThreadPool* pool)
+{
+    // num / steps = phi_steps * theta_steps = phi_steps * phi_steps * 0.5 <=>
+    double d_phi_steps = std::sqrt(2.0 * num / steps);
+    size_t phi_steps = (size_t)d_phi_steps;
+    size_t theta_steps = (size_t)(d_phi_steps * 0.5);
+
+    std::vector<Vec3> points(steps * phi_steps * theta_steps, position);
+
+    forChunks(points.size(), pool, [&](size_t begin, size_t end)
+    {
+        Random::Stream rng(seed, SPHERE_STEPS);
+        for (size_t i = begin; i < end; i++)
+        {
+            // Points are ordered by step, then phi, then theta
+            const size_t theta_idx = i % theta_steps + 1;
+            const size_t phi_idx = (i / theta_steps) % phi_steps + 1;
+            const size_t step_idx = i / (theta_steps * phi_steps) + 1;
+
+            double r = step_idx / (double)steps;
+            double phi = 2.0 * M_PI * (phi_idx / (double)(phi_steps + 1));
+            double theta = M_PI * (theta_idx / (double)(theta_steps + 1));
+
+            rng.seek(i);
+            auto& p = points[i];
+            p += std::sin(theta) * std::cos(phi) * axes[0] * r * rng.normal(1, noise_sigma);
+            p += std::sin(theta) * std::sin(phi) * axes[1] * r * rng.normal(1, noise_sigma);
+            p += std::cos(theta) * axes[2] * r * rng.normal(1, noise_sigma);
+        }
+    });
+
+    return points;
+}
+
+void PointDistribution::CurveTable::add(const Vec3& position, const Vec3& tangent)
+{
+    lengths.push_back(positions.empty() ? 0.0 : lengths.back() + (position - positions.back()).length());
+    positions.push_back(position);
+    tangents.push_back(tangent);
+}
+
+void PointDistribution::CurveTable::evaluate(double s, Vec3& position, Vec3& tangent) const
+{
+    if (positions.size() < 2)
+    {
+        position = positions.empty() ? Vec3() : positions[0];
+        tangent = tangents.empty() ? Vec3(1, 0, 0) : tangents[0];
+        return;
+    }
+
+    // Segment [i, i + 1] containing s
+    size_t i = std::upper_bound(lengths.begin(), lengths.end(), s) - lengths.begin();
+    i = std::min(std::max(i, (size_t)1), lengths.size() - 1) - 1;
+
+    const double segment = lengths[i + 1] - lengths[i];
+    const double f = segment > 0.0 ? std::min(std::max((s - lengths[i]) / segment, 0.0), 1.0) : 0.0;
+
+    position = positions[i] + (positions[i + 1] - positions[i]) * f;
+    tangent = (tangents[i] + (tangents[i + 1] - tangents[i]) * f).normal();
+}
+
+std::vector<Geometry::Vec3> PointDistribution::curves(const std::vector<CurveTable>& curves, double radius, size_t num, uint64_t seed, ThreadPool* pool)
+{
+    // Curves are laid end to end, offsets[c] is where curve c starts
+    std::vector<double> offsets(1, 0.0);
+    for (const auto& curve : curves) offsets.push_back(offsets.back() + curve.length());
+
+    const double total = offsets.back();
+    if (curves.empty() || total <= 0.0) return {};
+
+    std::vector<Vec3> points(num);
+
+    forChunks(num, pool, [&](size_t begin, size_t end)
+    {
+        Random::Stream rng(seed, CURVE);
+        for (size_t i = begin; i < end; i++)
+        {
+            rng.seek(i);
+            double s = rng.uniform(0.0, total);
+            double angle = rng.uniform(0.0, 2.0 * M_PI);
+            double r = rng.uniform() * radius;
+
+            size_t c = std::upper_bound(offsets.begin(), offsets.end(), s) - offsets.begin() - 1;
+            c = std::min(c, curves.size() - 1);
+
+            Vec3 position, tangent;
+            curves[c].evaluate(s - offsets[c], position, tangent);
+
+            // Random direction orthogonal to the tangent
+            Vec3 normal = std::abs(tangent.x) > std::abs(tangent.y) ? Vec3(-tangent.z, 0, tangent.x) : Vec3(0, tangent.z, -tangent.y);
+            normal = normal.normal();
+            const Vec3 binormal = tangent ^ normal;
+
+            points[i] = position + (normal * std::cos(angle) + binormal * std::sin(angle)) * r;
+        }
+    });
+
+    return points;
+}
+
+std::vector<Geometry::Vec3> PointDistribution::uniformConvex(const std::vector<Geometry::Plane>& planes, const Vec3& min, const Vec3& max, size_t num, uint64_t seed, uint32_t region)
+{
+    constexpr size_t MAX_TRIES_PER_POINT = 100;
+
+    std::vector<Vec3> points;
+    points.reserve(num);
+
+    // Tries are numbered within the region, so the result doesn't depend on other regions
+    Random::Stream rng(seed, CONVEX);
+    for (uint64_t i = 0; points.size() < num && i < num * MAX_TRIES_PER_POINT; i++)
+    {
+        rng.seek(((uint64_t)region << 32) | i);
+        Vec3 p(rng.uniform(min.x, max.x), rng.uniform(min.y, max.y), rng.uniform(min.z, max.z));
+
+        bool inside = std::all_of(planes.begin(), planes.end(), [&](const Geometry::Plane& plane) { return plane.side(p) < 0; });
+        if (inside) points.push_back(p);
+    }
+
+    return points;
+}
+
+std::vector<Geometry::Vec3> PointDistribution::removeDuplicates(const std::vector<Vec3>& points, double tolerance)
+{
+    if (tolerance <= 0.0) return points;
+
+    // Accepted points are hashed into a grid with cell size tolerance, so only the 27
+    // cells around a point can contain points closer than tolerance. Points in the
+    // same cell are linked through next, with heads holding the last point per cell.
+    struct CellHash
+    {
+        size_t operator()(const std::array<int64_t, 3>& c) const
+        {
+            // Multiplied unsigned, where overflow wraps
+            return (size_t)((uint64_t)c[0] * 73856093u ^ (uint64_t)c[1] * 19349663u ^ (uint64_t)c[2] * 83492791u);
+        }
+    };
+
+    std::unordered_map<std::array<int64_t, 3>, size_t, CellHash> heads;
+    std::vector<size_t> next;
+
+    constexpr size_t END = std::numeric_limits<size_t>::max();
+
+    // Cell indices are clamped to fit in an int64 with room for the neighbouring cells. Points
+    // beyond share the outermost cells, which only makes their comparisons slower.
+    auto index = [tolerance](double x) -> int64_t
+    {
+        constexpr double LIMIT = 4611686018427387904.0;  // 2^62
+        const double i = std::floor(x / tolerance);
+        if (!(i > -LIMIT)) return -(int64_t(1) << 62);
+        if (!(i < LIMIT)) return int64_t(1) << 62;
+        return (int64_t)i;
+    };
+
+    auto cell = [&index](const Vec3& p) -> std::array<int64_t, 3>
+    {
+        return { index(p.x), index(p.y), index(p.z) };
+    };
+
+    std::vector<Vec3> new_points;
+
+    for (const auto& p0 : points)
+    {
+        const auto c = cell(p0);
+
+        bool add = true;
+        for (int64_t x = c[0] - 1; add && x <= c[0] + 1; x++)
+        {
+            for (int64_t y = c[1] - 1; add && y <= c[1] + 1; y++)
+            {
+                for (int64_t z = c[2] - 1; add && z <= c[2] + 1; z++)
+                {
+                    auto it = heads.find({ x, y, z });
+                    if (it == heads.end()) continue;
+
+                    for (size_t i = it->second; i != END; i = next[i])
+                    {
+                        if ((p0 - new_points[i]).length() < tolerance)
+                        {
+                            add = false;
+                            break;
+                        }
+                    }
+                }
+            }
+        }
+
+        if (add)
+        {
+            auto [it, inserted] = heads.try_emplace(c, END);
+            next.push_back(it->second);
+            it->second = new_points.size();
+            new_points.push_back(p0);
+        }
+    }
+
+    return new_points;
+}
+
+std::vector<size_t> PointDistribution::spatialOrder(const std::vector<Vec3>& points, const Vec3& min, const Vec3& max, Curve curve)
+{
+    constexpr int BITS = 21;
+    constexpr uint32_t MAX_CELL = (1u << BITS) - 1;
+
+    std::vector<size_t> order(points.size());
+    for (size_t i = 0; i < points.size(); i++) order[i] = i;
+    if (curve == Curve::NONE) return order;
+
+    // Spreads the low 21 bits of v to every third bit
+    auto spread = [](uint64_t v)
+    {
+        v &= MAX_CELL;
+        v = (v | v << 32) & 0x1F00000000FFFF;
+        v = (v | v << 16) & 0x1F0000FF0000FF;
+        v = (v | v << 8) & 0x100F00F00F00F00F;
+        v = (v | v << 4) & 0x10C30C30C30C30C3;
+        v = (v | v << 2) & 0x1249249249249249;
+        return v;
+    };
+
+    auto quantize = [](double x, double lo, double hi)
+    {
+        const double t = hi > lo ? (x - lo) / (hi - lo) : 0.0;
+        return (uint32_t)(std::min(std::max(t, 0.0), 1.0) * MAX_CELL);
+    };
+
+    // Hilbert index in the transposed form of Skilling, "Programming the Hilbert curve", 2004:
+    // interleaving the bits of the transformed coordinates gives the distance along the curve
+    auto hilbert = [](std::array<uint32_t, 3>& x)
+    {
+        for (uint32_t q = 1u << (BITS - 1); q > 1; q >>= 1)
+        {
+            const uint32_t p = q - 1;
+            for (int i = 0; i < 3; i++)
+            {
+                if (x[i] & q)
+                {
+                    x[0] ^= p;
+                }
+                else
+                {
+                    const uint32_t t = (x[0] ^ x[i]) & p;
+                    x[0] ^= t;
+                    x[i] ^= t;
+                }
+            }
+        }
+
+        x[1] ^= x[0];
+        x[2] ^= x[1];
+
+        uint32_t t = 0;
+        for (uint32_t q = 1u << (BITS - 1); q > 1; q >>= 1)
+        {
+            if (x[2] & q) t ^= q - 1;
+        }
+        for (int i = 0; i < 3; i++) x[i] ^= t;
+    };
+
+    std::vector<std::pair<uint64_t, size_t>> codes(points.size());
+    for (size_t i = 0; i < points.size(); i++)
+    {
+        const Vec3& p = points[i];
+        std::array<uint32_t, 3> x = { quantize(p.x, min.x, max.x), quantize(p.y, min.y, max.y), quantize(p.z, min.z, max.z) };
+
+        if (curve == Curve::MORTON)
+        {
+            codes[i] = { spread(x[0]) | spread(x[1]) << 1 | spread(x[2]) << 2, i };
+        }
+        else
+        {
+            hilbert(x);
+            codes[i] = { spread(x[0]) << 2 | spread(x[1]) << 1 | spread(x[2]), i };
+        }
+    }
+    std::sort(codes.begin(), codes.end());
+
+    for (size_t i = 0; i < points.size(); i++) order[i] = codes[i].second;
+    return order;
+}
+
+std::vector<Geometry::Vec3> PointDistribution::sortSpatially(const std::vector<Vec3>& points, Curve curve)
+{
+    if (curve == Curve::NONE) return points;
+
+    Geometry::Bounds bounds;
+    bounds.compute(points);
+
+    std::vector<Vec3> sorted(points.size());
+    const std::vector<size_t> order = spatialOrder(points, bounds.min, bounds.max, curve);
+    for (size_t i = 0; i < points.size(); i++) sorted[i] = points[order[i]];
+
+    return sorted;
+}
+
+void PointDistribution::uniformBoundingBox(const Vec3& min, const Vec3& max, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool)
+{
+    resize(points, num);
+
+    const Vec3 extent = max - min;
+
+    forChunks(num, pool, [&](size_t begin, size_t end)
+    {
+        double u[3][BATCH_SIZE];
+
+        for (size_t b = begin; b < end; b += BATCH_SIZE)
+        {
+            const size_t n = std::min(BATCH_SIZE, end - b);
+            uniforms(seed, BOUNDING_BOX, b, n, 3, u);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                points.x[b + j] = min.x + extent.x * u[0][j];
+                points.y[b + j] = min.y + extent.y * u[1][j];
+                points.z[b + j] = min.z + extent.z * u[2][j];
+            }
+        }
+    });
+
+    points.updateBounds();
+}
+
+void PointDistribution::sphereQuadratic(const Vec3& position, const std::array<Vec3, 3>& axes, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool)
+{
+    resize(points, num);
+
+    forChunks(num, pool, [&](size_t begin, size_t end)
+    {
+        double u[3][BATCH_SIZE];
+        double sin_theta[BATCH_SIZE], cos_theta[BATCH_SIZE], sin_phi[BATCH_SIZE], cos_phi[BATCH_SIZE];
+
+        for (size_t b = begin; b < end; b += BATCH_SIZE)
+        {
+            const size_t n = std::min(BATCH_SIZE, end - b);
+            uniforms(seed, SPHERE, b, n, 3, u);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                u[0][j] *= M_PI;
+                u[1][j] *= 2.0 * M_PI;
+            }
+
+            SimdMath::sinCos(u[0], sin_theta, cos_theta, n);
+            SimdMath::sinCos(u[1], sin_phi, cos_phi, n);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                const double r = u[2][j];
+                const double a = sin_theta[j] * cos_phi[j], c = sin_theta[j] * sin_phi[j], d = cos_theta[j];
+
+                points.x[b + j] = position.x + a * axes[0].x * r + c * axes[1].x * r + d * axes[2].x * r;
+                points.y[b + j] = position.y + a * axes[0].y * r + c * axes[1].y * r + d * axes[2].y * r;
+                points.z[b + j] = position.z + a * axes[0].z * r + c * axes[1].z * r + d * axes[2].z * r;
+            }
+        }
+    });
+
+    points.updateBounds();
+}
+
+void PointDistribution::diskQuadratic(const Vec3& position, const std::array<Vec3, 3>& axes, size_t axis, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool)
+{
+    unsigned idx = axis - 1;
+    const Vec3& a0 = axes[std::min(idx - 1u, 2u)]; // relies on unsigned wrap-around
+    const Vec3& a1 = axes[idx + 1 > 2 ? 0 : idx + 1];
+
+    resize(points, num);
+
+    forChunks(num, pool, [&](size_t begin, size_t end)
+    {
+        double u[2][BATCH_SIZE];
+        double sin_phi[BATCH_SIZE], cos_phi[BATCH_SIZE];
+
+        for (size_t b = begin; b < end; b += BATCH_SIZE)
+        {
+            const size_t n = std::min(BATCH_SIZE, end - b);
+            uniforms(seed, DISK, b, n, 2, u);
+
+            for (size_t j = 0; j < n; j++) u[0][j] *= 2.0 * M_PI;
+
+            SimdMath::sinCos(u[0], sin_phi, cos_phi, n);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                const double c = cos_phi[j] * u[1][j], s = sin_phi[j] * u[1][j];
+
+                points.x[b + j] = position.x + c * a0.x + s * a1.x;
+                points.y[b + j] = position.y + c * a0.y + s * a1.y;
+                points.z[b + j] = position.z + c * a0.z + s * a1.z;
+            }
+        }
+    });
+
+    points.updateBounds();
+}
+
+void PointDistribution::diskSteps(const Vec3& position, const std::array<Vec3, 3>& axes, size_t steps, size_t axis, double noise_sigma, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool)
+{
+    size_t step_points = num / steps;
+    unsigned idx = axis - 1;
+    const Vec3& a0 = axes[std::min(idx - 1u, 2u)];
+    const Vec3& a1 = axes[idx + 1 > 2 ? 0 : idx + 1];
+
+    resize(points, step_points * steps);
+
+    forChunks(points.size(), pool, [&](size_t begin, size_t end)
+    {
+        double u[4][BATCH_SIZE];
+        double phi[BATCH_SIZE], sin_phi[BATCH_SIZE], cos_phi[BATCH_SIZE];
+        double noise0[BATCH_SIZE], noise1[BATCH_SIZE];
+
+        for (size_t b = begin; b < end; b += BATCH_SIZE)
+        {
+            const size_t n = std::min(BATCH_SIZE, end - b);
+            uniforms(seed, DISK_STEPS, b, n, 4, u);
+
+            for (size_t j = 0; j < n; j++) phi[j] = ((b + j) % step_points / (double)step_points) * 2.0 * M_PI;
+
+            SimdMath::sinCos(phi, sin_phi, cos_phi, n);
+            SimdMath::normal(u[0], u[1], 1.0, noise_sigma, noise0, n);
+            SimdMath::normal(u[2], u[3], 1.0, noise_sigma, noise1, n);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                const double r = ((b + j) / step_points + 1) / (double)steps;
+                const double c = cos_phi[j] * r * noise0[j], s = sin_phi[j] * r * noise1[j];
+
+                points.x[b + j] = position.x + c * a0.x + s * a1.x;
+                points.y[b + j] = position.y + c * a0.y + s * a1.y;
+                points.z[b + j] = position.z + c * a0.z + s * a1.z;
+            }
+        }
+    });
+
+    points.updateBounds();
+}
+
+void PointDistribution::sphereSteps(const Vec3& position, const std::array<Vec3, 3>& axes, size_t steps, double noise_sigma, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool)
+{
+    double d_phi_steps = std::sqrt(2.0 * num / steps);
+    size_t phi_steps = (size_t)d_phi_steps;
+    size_t theta_steps = (size_t)(d_phi_steps * 0.5);
+
+    resize(points, steps * phi_steps * theta_steps);
+
+    forChunks(points.size(), pool, [&](size_t begin, size_t end)
+    {
+        double u[6][BATCH_SIZE];
+        double theta[BATCH_SIZE], phi[BATCH_SIZE], r[BATCH_SIZE];
+        double sin_theta[BATCH_SIZE], cos_theta[BATCH_SIZE], sin_phi[BATCH_SIZE], cos_phi[BATCH_SIZE];
+        double noise[3][BATCH_SIZE];
+
+        for (size_t b = begin; b < end; b += BATCH_SIZE)
+        {
+            const size_t n = std::min(BATCH_SIZE, end - b);
+            uniforms(seed, SPHERE_STEPS, b, n, 6, u);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                const size_t i = b + j;
+                theta[j] = M_PI * ((i % theta_steps + 1) / (double)(theta_steps + 1));
+                phi[j] = 2.0 * M_PI * (((i / theta_steps) % phi_steps + 1) / (double)(phi_steps + 1));
+                r[j] = (i / (theta_steps * phi_steps) + 1) / (double)steps;
+            }
+
+            SimdMath::sinCos(theta, sin_theta, cos_theta, n);
+            SimdMath::sinCos(phi, sin_phi, cos_phi, n);
+            for (int k = 0; k < 3; k++) SimdMath::normal(u[2 * k], u[2 * k + 1], 1.0, noise_sigma, noise[k], n);
+
+            for (size_t j = 0; j < n; j++)
+            {
+                const double a = sin_theta[j] * cos_phi[j], c = sin_theta[j] * sin_phi[j], d = cos_theta[j];
+                const double r0 = r[j] * noise[0][j], r1 = r[j] * noise[1][j], r2 = r[j] * noise[2][j];
+
+                points.x[b + j] = position.x + a * axes[0].x * r0 + c * axes[1].x * r1 + d * axes[2].x * r2;
+                points.y[b + j] = position.y + a * axes[0].y * r0 + c * axes[1].y * r1 + d * axes[2].y * r2;
+                points.z[b + j] = position.z + a * axes[0].z * r0 + c * axes[1].z * r1 + d * axes[2].z * r2;
+            }
+        }
+    });
+
+    points.updateBounds();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+
+#include "geometry.h"
+#include "random.h"
+#include "thread-pool.h"
+#include "vertex-buffer.h"
+
+namespace PointDistribution
+{
+    // Random stream of each distribution, so equal seeds don't give correlated distributions
+    enum StreamId : uint32_t { BOUNDING_BOX = 1, SPHERE, DISK, SPHERE_STEPS, DISK_STEPS, CURVE, CONVEX };
+
+    // Every point is drawn from its own position in a counter based random stream, so the
+    // result only depends on the arguments and seed. Large distributions are generated
+    // in parallel chunks if a pool is given, with bit-identical output for any pool size.
+
+    std::vector<Geometry::Vec3> uniformBoundingBox(const Geometry::Vec3& min, const Geometry::Vec3& max, size_t num, uint64_t seed, ThreadPool* pool = nullptr);
+
+    std::vector<Geometry::Vec3> sphereQuadratic(const Geometry::Vec3& position, const std::array<Geometry::Vec3, 3>& axes, size_t num, uint64_t seed, ThreadPool* pool = nullptr);
+
+    std::vector<Geometry::Vec3> diskQuadratic(const Geometry::Vec3& position, const std::array<Geometry::Vec3, 3>& axes, size_t axis, size_t num, uint64_t seed, ThreadPool* pool = nullptr);
+
+    std::vector<Geometry::Vec3> sphereSteps(const Geometry::Vec3& position, const std::array<Geometry::Vec3, 3>& axes, size_t steps, double noise_sigma, size_t num, uint64_t seed, ThreadPool* pool = nullptr);
+
+    std::vector<Geometry::Vec3> diskSteps(const Geometry::Vec3& position, const std::array<Geometry::Vec3, 3>& axes, size_t steps, size_t axis, double noise_sigma, size_t num, uint64_t seed, ThreadPool* pool = nullptr);
+
+    // Curve sampled once into a polyline with cumulative arc length, so that points at a
+    // given length are found by binary search instead of solving for the curve parameter
+    struct CurveTable
+    {
+        void add(const Geometry::Vec3& position, const Geometry::Vec3& tangent);
+
+        double length() const { return lengths.empty() ? 0.0 : lengths.back(); }
+
+        // Position and unit tangent at arc length s, interpolated linearly between samples
+        void evaluate(double s, Geometry::Vec3& position, Geometry::Vec3& tangent) const;
+
+        std::vector<Geometry::Vec3> positions, tangents;
+        std::vector<double> lengths;
+    };
+
+    // Points in tubes with the given radius around the curves, uniformly by arc length so
+    // longer curves get proportionally more points
+    std::vector<Geometry::Vec3> curves(const std::vector<CurveTable>& curves, double radius, size_t num, uint64_t seed, ThreadPool* pool = nullptr);
+
+    // Points uniformly inside the convex region of [min, max] below all planes, by rejection.
+    // Each region draws from its own part of the stream, so regions can be filled in parallel.
+    // Returns fewer points if the region is too thin to fill within a bounded number of tries.
+    std::vector<Geometry::Vec3> uniformConvex(const std::vector<Geometry::Plane>& planes, const Geometry::Vec3& min, const Geometry::Vec3& max, size_t num, uint64_t seed, uint32_t region = 0);
+
+    std::vector<Geometry::Vec3> removeDuplicates(const std::vector<Geometry::Vec3>& points, double tolerance);
+
+    // Space filling curves for spatialOrder. Hilbert curves never jump between distant
+    // cells, Morton curves are cheaper to compute but jump at every power of two.
+    enum class Curve { NONE, MORTON, HILBERT };
+
+    // Indices of the points sorted along the curve through [min, max], quantized to 2^21
+    // cells per axis, so that consecutive points are close to each other. Ties keep their
+    // order, NONE returns the identity.
+    std::vector<size_t> spatialOrder(const std::vector<Geometry::Vec3>& points, const Geometry::Vec3& min, const Geometry::Vec3& max, Curve curve);
+
+    // Points reordered along the curve through their bounding box, so that cells built one
+    // after the other and the cells of one worker are neighbours
+    std::vector<Geometry::Vec3> sortSpatially(const std::vector<Geometry::Vec3>& points, Curve curve);
+
+    // Batch versions for very large point clouds, filling structure of arrays buffers. They
+    // draw the same random numbers as the functions above and evaluate sin, cos and log with
+    // SIMD approximations where available, so points agree with them up to rounding.
+
+    void uniformBoundingBox(const Geometry::Vec3& min, const Geometry::Vec3& max, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool = nullptr);
+
+    void sphereQuadratic(const Geometry::Vec3& position, const std::array<Geometry::Vec3, 3>& axes, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool = nullptr);
+
+    void diskQuadratic(const Geometry::Vec3& position, const std::array<Geometry::Vec3, 3>& axes, size_t axis, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool = nullptr);
+
+    void sphereSteps(const Geometry::Vec3& position, const std::array<Geometry::Vec3, 3>& axes, size_t steps, double noise_sigma, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool = nullptr);
+
+    void diskSteps(const Geometry::Vec3& position, const std::array<Geometry::Vec3, 3>& axes, size_t steps, size_t axis, double noise_sigma, size_t num, uint64_t seed, Geometry::VertexBuffer& points, ThreadPool* pool = nullptr);
+}
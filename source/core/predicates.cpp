@@ -0,0 +1,155 @@
+#include "predicates.h"
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+    // Expansions are sums of non-overlapping doubles sorted by increasing magnitude, with
+    // zero components eliminated. The sign of an expansion is the sign of its last component.
+
+    constexpr double EPSILON = std::numeric_limits<double>::epsilon() * 0.5;
+
+    // x + y = a + b exactly
+    inline void twoSum(double a, double b, double& x, double& y)
+    {
+        x = a + b;
+        const double b_virtual = x - a;
+        const double a_virtual = x - b_virtual;
+        y = (a - a_virtual) + (b - b_virtual);
+    }
+
+    // x + y = a * b exactly, fma rounds only once
+    inline void twoProduct(double a, double b, double& x, double& y)
+    {
+        x = a * b;
+        y = std::fma(a, b, -x);
+    }
+
+    // h = e + b, h needs room for e_length + 1 components
+    int growExpansion(int e_length, const double* e, double b, double* h)
+    {
+        int h_length = 0;
+        double q = b;
+        for (int i = 0; i < e_length; i++)
+        {
+            double sum, error;
+            twoSum(q, e[i], sum, error);
+            q = sum;
+            if (error != 0.0) h[h_length++] = error;
+        }
+        if (q != 0.0 || h_length == 0) h[h_length++] = q;
+        return h_length;
+    }
+
+    // h = e * b, h needs room for 2 * e_length components
+    int scaleExpansion(int e_length, const double* e, double b, double* h)
+    {
+        int h_length = 0;
+        double q, error;
+        twoProduct(e[0], b, q, error);
+        if (error != 0.0) h[h_length++] = error;
+
+        for (int i = 1; i < e_length; i++)
+        {
+            double product, product_error, sum;
+            twoProduct(e[i], b, product, product_error);
+            twoSum(q, product_error, sum, error);
+            if (error != 0.0) h[h_length++] = error;
+            twoSum(product, sum, q, error);
+            if (error != 0.0) h[h_length++] = error;
+        }
+        if (q != 0.0 || h_length == 0) h[h_length++] = q;
+        return h_length;
+    }
+
+    // h = e + f by adding one component of f at a time, h needs room for e_length + f_length
+    int sumExpansions(int e_length, const double* e, int f_length, const double* f, double* h)
+    {
+        double buffer[2][64];
+        const double* current = e;
+        int length = e_length;
+        for (int i = 0; i < f_length; i++)
+        {
+            double* next = (i + 1 == f_length) ? h : buffer[i % 2];
+            length = growExpansion(length, current, f[i], next);
+            current = next;
+        }
+        if (f_length == 0)
+        {
+            for (int i = 0; i < length; i++) h[i] = e[i];
+        }
+        return length;
+    }
+
+    int sign(double x)
+    {
+        return (x > 0.0) - (x < 0.0);
+    }
+
+    // (p1 - p0) . (2x - p0 - p1) with exact arithmetic
+    int bisectorExact(const Geometry::Vec3& p0, const Geometry::Vec3& p1, const Geometry::Vec3& x)
+    {
+        const double a[3][2] = { { p0.x, p1.x }, { p0.y, p1.y }, { p0.z, p1.z } };
+        const double b[3] = { x.x, x.y, x.z };
+
+        double total[64];
+        int total_length = 0;
+
+        for (int k = 0; k < 3; k++)
+        {
+            // p1 - p0, at most 2 components
+            double difference[2];
+            const double minus_p0 = -a[k][0];
+            const int difference_length = growExpansion(1, &minus_p0, a[k][1], difference);
+
+            // 2x - p0 - p1, at most 3 components, scaling by 2 is exact
+            double twice_x = 2.0 * b[k], partial[2], offset[3];
+            const int partial_length = growExpansion(1, &twice_x, -a[k][0], partial);
+            const int offset_length = growExpansion(partial_length, partial, -a[k][1], offset);
+
+            // Product of both, at most 12 components
+            double product[12], scaled[6];
+            int product_length = 0;
+            for (int i = 0; i < difference_length; i++)
+            {
+                const int scaled_length = scaleExpansion(offset_length, offset, difference[i], scaled);
+
+                double sum[12];
+                const int sum_length = sumExpansions(product_length, product, scaled_length, scaled, sum);
+                for (int j = 0; j < sum_length; j++) product[j] = sum[j];
+                product_length = sum_length;
+            }
+
+            double sum[64];
+            const int sum_length = sumExpansions(total_length, total, product_length, product, sum);
+            for (int j = 0; j < sum_length; j++) total[j] = sum[j];
+            total_length = sum_length;
+        }
+
+        return total_length > 0 ? sign(total[total_length - 1]) : 0;
+    }
+}
+
+int Predicates::bisector(const Geometry::Vec3& p0, const Geometry::Vec3& p1, const Geometry::Vec3& x)
+{
+    const double a[3] = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+    const double b[3] = { 2.0 * x.x - p0.x - p1.x, 2.0 * x.y - p0.y - p1.y, 2.0 * x.z - p0.z - p1.z };
+    const double magnitude[3] = {
+        2.0 * std::abs(x.x) + std::abs(p0.x) + std::abs(p1.x),
+        2.0 * std::abs(x.y) + std::abs(p0.y) + std::abs(p1.y),
+        2.0 * std::abs(x.z) + std::abs(p0.z) + std::abs(p1.z)
+    };
+
+    const double d = a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+
+    // Each term is off by at most 4 roundings of the magnitude product and the sum adds 2,
+    // the bound is rounded up to 8 to cover the rounding of the bound itself
+    const double permanent = std::abs(a[0]) * magnitude[0] + std::abs(a[1]) * magnitude[1] + std::abs(a[2]) * magnitude[2];
+    const double error_bound = 8.0 * EPSILON * permanent;
+
+    if (d > error_bound) return 1;
+    if (d < -error_bound) return -1;
+
+    return bisectorExact(p0, p1, x);
+}
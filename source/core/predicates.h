@@ -0,0 +1,14 @@
+#pragma once
+
+#include "geometry.h"
+
+// Adaptive precision geometric predicates (Shewchuk, "Adaptive Precision Floating-Point
+// Arithmetic and Fast Robust Geometric Predicates", 1997). The result is computed in floating
+// point first and only recomputed with exact expansion arithmetic when it is within the
+// rounding error bound, so the sign is always correct.
+namespace Predicates
+{
+    // Sign of |x - p0|^2 - |x - p1|^2, i.e. 1 if x is closer to p1, -1 if it is closer to
+    // p0 and 0 if it lies exactly on the bisector plane of p0 and p1
+    int bisector(const Geometry::Vec3& p0, const Geometry::Vec3& p1, const Geometry::Vec3& x);
+}
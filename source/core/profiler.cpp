@@ -0,0 +1,158 @@
+#include "profiler.h"
+
+#include <cstdlib>
+#include <new>
+#include <fstream>
+#include <sstream>
+#include <map>
+
+thread_local size_t Profiling::Detail::allocations = 0;
+std::atomic<size_t> Profiling::Detail::total_allocations = 0;
+bool Profiling::Detail::counting = false;
+
+void* Profiling::Detail::allocate(size_t size)
+{
+    allocations++;
+    total_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void Profiling::Detail::deallocate(void* p) noexcept
+{
+    std::free(p);
+}
+
+size_t Profiling::threadAllocations()
+{
+    return Detail::allocations;
+}
+
+size_t Profiling::totalAllocations()
+{
+    return Detail::total_allocations.load(std::memory_order_relaxed);
+}
+
+bool Profiling::countsAllocations()
+{
+    return Detail::counting;
+}
+
+Profiling::Profiler::Profiler() : start(std::chrono::steady_clock::now()), lanes(1) { }
+
+double Profiling::Profiler::now() const
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void Profiling::Profiler::reserveLanes(size_t num_lanes)
+{
+    if (lanes.size() < num_lanes) lanes.resize(num_lanes);
+}
+
+void Profiling::Profiler::record(const char* name, size_t lane, double begin, double end, size_t fragment)
+{
+    lanes[lane].push_back({ name, lane, fragment, begin, end });
+}
+
+size_t Profiling::Profiler::addFragments(size_t num)
+{
+    const size_t first = fragments.size();
+    fragments.resize(first + num);
+    for (size_t i = 0; i < num; i++) fragments[first + i].seed = i;
+    return first;
+}
+
+Profiling::Profiler::Scope::Scope(Profiler* profiler, const char* name, size_t lane, size_t fragment)
+    : profiler(profiler), name(name), lane(lane), fragment(fragment), begin(profiler ? profiler->now() : 0.0) { }
+
+Profiling::Profiler::Scope::~Scope()
+{
+    if (profiler) profiler->record(name, lane, begin, profiler->now(), fragment);
+}
+
+std::string Profiling::Profiler::report() const
+{
+    struct Phase
+    {
+        double seconds = 0.0;
+        size_t calls = 0;
+    };
+
+    // Per-fragment events are summed into their phase as well
+    std::map<std::string, Phase> phases;
+    for (const auto& lane : lanes)
+    {
+        for (const Event& e : lane)
+        {
+            Phase& phase = phases[e.name];
+            phase.seconds += e.end - e.begin;
+            phase.calls++;
+        }
+    }
+
+    Geometry::PlaneTestStats planes;
+    size_t allocations = 0;
+    for (const auto& f : fragments)
+    {
+        planes += f.planes;
+        allocations += f.allocations;
+    }
+
+    // Allocations are left out where they aren't counted rather than reported as 0
+    const bool counted = countsAllocations();
+
+    std::ostringstream out;
+    out.precision(9);
+
+    out << "{\"phases\":{";
+    for (auto it = phases.begin(); it != phases.end(); ++it)
+    {
+        out << (it == phases.begin() ? "" : ",") << '"' << it->first << "\":{\"seconds\":" << it->second.seconds << ",\"calls\":" << it->second.calls << '}';
+    }
+
+    out << "},\"counters\":{\"planes_tested\":" << planes.tested() << ",\"planes_clipped\":" << planes.clipped
+        << ",\"early_outs\":" << planes.earlyOuts() << ",\"vertices_scanned\":" << planes.scanned
+        << ",\"script_calls\":" << script_calls;
+    if (counted) out << ",\"allocations\":" << allocations;
+    out << '}';
+
+    out << ",\"fragments\":[";
+    for (size_t i = 0; i < fragments.size(); i++)
+    {
+        const FragmentProfile& f = fragments[i];
+        out << (i ? "," : "") << "{\"seed\":" << f.seed << ",\"worker\":" << f.worker << ",\"build\":" << f.build << ",\"intersect\":" << f.intersect
+            << ",\"planes_tested\":" << f.planes.tested() << ",\"planes_clipped\":" << f.planes.clipped
+            << ",\"early_outs\":" << f.planes.earlyOuts() << ",\"vertices_scanned\":" << f.planes.scanned;
+        if (counted) out << ",\"allocations\":" << f.allocations;
+        out << '}';
+    }
+    out << "]}";
+
+    return out.str();
+}
+
+bool Profiling::Profiler::writeChromeTrace(const std::string& path) const
+{
+    std::ofstream out(path);
+    if (!out) return false;
+
+    out.precision(3);
+    out << std::fixed << "{\"traceEvents\":[\n";
+
+    bool first = true;
+    for (const auto& lane : lanes)
+    {
+        for (const Event& e : lane)
+        {
+            out << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << e.lane
+                << ",\"ts\":" << e.begin * 1e6 << ",\"dur\":" << (e.end - e.begin) * 1e6;
+            if (e.fragment != NO_FRAGMENT) out << ",\"args\":{\"fragment\":" << e.fragment << '}';
+            out << '}';
+            first = false;
+        }
+    }
+
+    out << "\n]}\n";
+    return (bool)out;
+}
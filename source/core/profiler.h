@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <cstddef>
+
+#include "vertex-buffer.h"
+
+namespace Profiling
+{
+    // Timed region on one lane, lane 0 is the calling thread and lane w + 1 is pool worker w
+    struct Event
+    {
+        const char* name;
+        size_t lane;
+        size_t fragment;
+        double begin, end;
+    };
+
+    // Time and plane work spent on one seed. Allocations include the buffers of the finished
+    // cell and fragment, clipping itself doesn't allocate once the worker's buffers have grown.
+    // seed is the index within the fracture that built it, e.g. the coarse or the fine level.
+    struct FragmentProfile
+    {
+        double build = 0.0, intersect = 0.0;
+        size_t seed = 0, worker = 0, allocations = 0;
+        Geometry::PlaneTestStats planes;
+    };
+
+    // Heap allocations made so far by the calling thread and by all threads. They are only
+    // counted in programs that include count-allocations.h, a Maya plugin can't replace
+    // operator new.
+    size_t threadAllocations();
+    size_t totalAllocations();
+    bool countsAllocations();
+
+    namespace Detail
+    {
+        extern thread_local size_t allocations;
+        extern std::atomic<size_t> total_allocations;
+        extern bool counting;
+
+        // Used by the operators in count-allocations.h. Defined out of line, so the compiler
+        // pairs each replaced operator new with its operator delete instead of malloc with free.
+        void* allocate(size_t size);
+        void deallocate(void* p) noexcept;
+    }
+
+    // Collects scoped phase timers, per-fragment costs and counters of one run. Lanes are
+    // only written by their own thread, so recording doesn't lock.
+    class Profiler
+    {
+    public:
+        static constexpr size_t NO_FRAGMENT = ~size_t(0);
+
+        Profiler();
+
+        // Seconds since construction
+        double now() const;
+
+        // Must be called before lanes are written from other threads
+        void reserveLanes(size_t num_lanes);
+
+        void record(const char* name, size_t lane, double begin, double end, size_t fragment = NO_FRAGMENT);
+
+        // Appends profiles for seeds 0 to num - 1 of another fracture and returns the index of
+        // the first, so runs with several levels keep the profiles of all of them
+        size_t addFragments(size_t num);
+
+        // Records the time from construction to destruction
+        class Scope
+        {
+        public:
+            Scope(Profiler* profiler, const char* name, size_t lane = 0, size_t fragment = NO_FRAGMENT);
+            ~Scope();
+
+            Scope(const Scope&) = delete;
+            Scope& operator=(const Scope&) = delete;
+
+        private:
+            Profiler* profiler;
+            const char* name;
+            size_t lane, fragment;
+            double begin;
+        };
+
+        // Whole run summary with phase totals, counters and per-fragment costs
+        std::string report() const;
+
+        // Writes events in the Chrome trace event format, viewable in chrome://tracing or Perfetto
+        bool writeChromeTrace(const std::string& path) const;
+
+        std::vector<FragmentProfile> fragments;
+
+        // Scripting calls made into Maya, which are slow compared to API calls
+        size_t script_calls = 0;
+
+    private:
+        std::chrono::steady_clock::time_point start;
+        std::vector<std::vector<Event>> lanes;
+    };
+}
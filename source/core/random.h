@@ -0,0 +1,106 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cmath>
+#include <limits>
+#include <random>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace Random
+{
+    // Philox4x32-10 counter based generator (Salmon et al., "Parallel random numbers: as easy
+    // as 1, 2, 3", 2011). Every output block is a pure function of counter and key.
+    inline std::array<uint32_t, 4> philox(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key)
+    {
+        constexpr uint32_t M0 = 0xD2511F53, M1 = 0xCD9E8D57;
+        constexpr uint32_t W0 = 0x9E3779B9, W1 = 0xBB67AE85;
+
+        for (int round = 0; round < 10; round++)
+        {
+            const uint64_t p0 = (uint64_t)M0 * counter[0];
+            const uint64_t p1 = (uint64_t)M1 * counter[2];
+
+            counter = {
+                (uint32_t)(p1 >> 32) ^ counter[1] ^ key[0], (uint32_t)p1,
+                (uint32_t)(p0 >> 32) ^ counter[3] ^ key[1], (uint32_t)p0
+            };
+
+            key[0] += W0;
+            key[1] += W1;
+        }
+
+        return counter;
+    }
+
+    // Uniform in [0, 1) from the top 52 bits, which SIMD code can convert exactly by
+    // placing them in the mantissa of a double in [1, 2)
+    inline double toUniform(uint64_t bits)
+    {
+        return (bits >> 12) * 0x1.0p-52;
+    }
+
+    // Random numbers for one (seed, stream) pair, addressed by sample index. The values drawn
+    // after seek(i) only depend on seed, stream and i, so samples can be generated in any
+    // order and by any number of threads with bit-identical results.
+    class Stream
+    {
+    public:
+        using result_type = uint64_t;
+
+        Stream(uint64_t seed, uint32_t stream)
+            : key{ (uint32_t)seed, (uint32_t)(seed >> 32) }, stream(stream) { seek(0); }
+
+        void seek(uint64_t sample)
+        {
+            this->sample = sample;
+            block = 0;
+            used = 2;
+        }
+
+        result_type operator()()
+        {
+            if (used == 2)
+            {
+                buffer = philox({ (uint32_t)sample, (uint32_t)(sample >> 32), block++, stream }, key);
+                used = 0;
+            }
+
+            const size_t i = 2 * used++;
+            return ((uint64_t)buffer[i] << 32) | buffer[i + 1];
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+        double uniform() { return toUniform((*this)()); }
+
+        double uniform(double a, double b) { return a + (b - a) * uniform(); }
+
+        // Box-Muller, one normal per two uniforms so the number of draws per sample is fixed
+        double normal(double mean, double sigma)
+        {
+            const double u0 = 1.0 - uniform(), u1 = uniform();
+            return mean + sigma * std::sqrt(-2.0 * std::log(u0)) * std::cos(2.0 * M_PI * u1);
+        }
+
+    private:
+        std::array<uint32_t, 2> key;
+        uint32_t stream;
+
+        uint64_t sample;
+        uint32_t block;
+        std::array<uint32_t, 4> buffer;
+        int used;
+    };
+
+    // New seed from the system entropy source, for runs that don't ask for a specific seed
+    inline uint64_t randomSeed()
+    {
+        std::random_device device;
+        return ((uint64_t)device() << 32) | device();
+    }
+}
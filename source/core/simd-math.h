@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cstddef>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// Elementwise math over arrays, using AVX2 approximations where available. Results are
+// within a few ulp of the standard library and the tail is computed with it.
+namespace SimdMath
+{
+#if defined(__AVX2__)
+    // sin and cos for 0 <= x < 2^20. Cody-Waite reduction to [-pi/4, pi/4] with pi/4 split
+    // in three parts, then Taylor polynomials which are exact to double precision there.
+    inline void sinCos(__m256d x, __m256d& s, __m256d& c)
+    {
+        const __m256d DP1 = _mm256_set1_pd(7.85398125648498535156e-1);
+        const __m256d DP2 = _mm256_set1_pd(3.77489470793079817668e-8);
+        const __m256d DP3 = _mm256_set1_pd(2.69515142907905952645e-15);
+        const __m256d FOUR_OVER_PI = _mm256_set1_pd(1.27323954473516268615);
+
+        // Octant rounded up to even, so the reduced argument is in [-pi/4, pi/4]
+        __m128i j = _mm256_cvttpd_epi32(_mm256_mul_pd(x, FOUR_OVER_PI));
+        j = _mm_and_si128(_mm_add_epi32(j, _mm_set1_epi32(1)), _mm_set1_epi32(~1));
+        const __m256d y = _mm256_cvtepi32_pd(j);
+
+        __m256d z = _mm256_sub_pd(x, _mm256_mul_pd(y, DP1));
+        z = _mm256_sub_pd(z, _mm256_mul_pd(y, DP2));
+        z = _mm256_sub_pd(z, _mm256_mul_pd(y, DP3));
+        const __m256d zz = _mm256_mul_pd(z, z);
+
+        // z - z^3/3! + ... - z^15/15!
+        __m256d ps = _mm256_set1_pd(-1.0 / 1307674368000.0);
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, zz), _mm256_set1_pd(1.0 / 6227020800.0));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, zz), _mm256_set1_pd(-1.0 / 39916800.0));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, zz), _mm256_set1_pd(1.0 / 362880.0));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, zz), _mm256_set1_pd(-1.0 / 5040.0));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, zz), _mm256_set1_pd(1.0 / 120.0));
+        ps = _mm256_add_pd(_mm256_mul_pd(ps, zz), _mm256_set1_pd(-1.0 / 6.0));
+        ps = _mm256_add_pd(_mm256_mul_pd(_mm256_mul_pd(ps, zz), z), z);
+
+        // 1 - z^2/2! + ... + z^16/16!
+        __m256d pc = _mm256_set1_pd(1.0 / 20922789888000.0);
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(-1.0 / 87178291200.0));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(1.0 / 479001600.0));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(-1.0 / 3628800.0));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(1.0 / 40320.0));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(-1.0 / 720.0));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(1.0 / 24.0));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(-0.5));
+        pc = _mm256_add_pd(_mm256_mul_pd(pc, zz), _mm256_set1_pd(1.0));
+
+        // Octants 2 and 6 swap the polynomials, 4 to 7 negate sin and 2 to 5 negate cos
+        const __m256i j64 = _mm256_cvtepi32_epi64(j);
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256d swap = _mm256_castsi256_pd(_mm256_cmpgt_epi64(_mm256_and_si256(j64, _mm256_set1_epi64x(2)), zero));
+        const __m256i sin_sign = _mm256_slli_epi64(_mm256_and_si256(j64, _mm256_set1_epi64x(4)), 61);
+        const __m256i cos_sign = _mm256_slli_epi64(_mm256_and_si256(_mm256_add_epi64(j64, _mm256_set1_epi64x(2)), _mm256_set1_epi64x(4)), 61);
+
+        s = _mm256_xor_pd(_mm256_blendv_pd(ps, pc, swap), _mm256_castsi256_pd(sin_sign));
+        c = _mm256_xor_pd(_mm256_blendv_pd(pc, ps, swap), _mm256_castsi256_pd(cos_sign));
+    }
+
+    // Natural logarithm for positive normal x. x = m 2^e with m in [sqrt(1/2), sqrt(2)) and
+    // log(m) = 2 atanh(t), t = (m - 1) / (m + 1), from its series up to t^21.
+    inline __m256d log(__m256d x)
+    {
+        const __m256i bits = _mm256_castpd_si256(x);
+        const __m256i MANTISSA = _mm256_set1_epi64x(0x000FFFFFFFFFFFFFll);
+        const __m256i ONE = _mm256_set1_epi64x(0x3FF0000000000000ll);
+
+        // m in [1, 2), moved to [sqrt(1/2), sqrt(2)) by halving the large ones
+        __m256d m = _mm256_castsi256_pd(_mm256_or_si256(_mm256_and_si256(bits, MANTISSA), ONE));
+        __m256i e = _mm256_sub_epi64(_mm256_srli_epi64(bits, 52), _mm256_set1_epi64x(1023));
+
+        const __m256d large = _mm256_cmp_pd(m, _mm256_set1_pd(1.41421356237309504880), _CMP_GE_OQ);
+        m = _mm256_blendv_pd(m, _mm256_mul_pd(m, _mm256_set1_pd(0.5)), large);
+        e = _mm256_sub_epi64(e, _mm256_castpd_si256(large)); // mask is -1 where large
+
+        // Exponents of normal doubles fit in 32 bits, gather the low halves for conversion
+        const __m256i low = _mm256_permutevar8x32_epi32(e, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+        const __m256d ef = _mm256_cvtepi32_pd(_mm256_castsi256_si128(low));
+
+        const __m256d t = _mm256_div_pd(_mm256_sub_pd(m, _mm256_set1_pd(1.0)), _mm256_add_pd(m, _mm256_set1_pd(1.0)));
+        const __m256d tt = _mm256_mul_pd(t, t);
+
+        __m256d p = _mm256_set1_pd(1.0 / 21.0);
+        for (int k = 19; k >= 1; k -= 2)
+        {
+            p = _mm256_add_pd(_mm256_mul_pd(p, tt), _mm256_set1_pd(1.0 / k));
+        }
+
+        const __m256d log_m = _mm256_mul_pd(_mm256_mul_pd(_mm256_set1_pd(2.0), t), p);
+        return _mm256_add_pd(_mm256_mul_pd(ef, _mm256_set1_pd(0.693147180559945309417)), log_m);
+    }
+#endif
+
+    // s[i] = sin(x[i]), c[i] = cos(x[i]) for 0 <= x[i] < 2^20
+    inline void sinCos(const double* x, double* s, double* c, size_t n)
+    {
+        size_t i = 0;
+#if defined(__AVX2__)
+        for (; i + 4 <= n; i += 4)
+        {
+            __m256d vs, vc;
+            sinCos(_mm256_loadu_pd(x + i), vs, vc);
+            _mm256_storeu_pd(s + i, vs);
+            _mm256_storeu_pd(c + i, vc);
+        }
+#endif
+        for (; i < n; i++)
+        {
+            s[i] = std::sin(x[i]);
+            c[i] = std::cos(x[i]);
+        }
+    }
+
+    // Box-Muller transform of two uniforms in [0, 1) each, in the same way as Random::Stream::normal
+    inline void normal(const double* u0, const double* u1, double mean, double sigma, double* out, size_t n)
+    {
+        size_t i = 0;
+#if defined(__AVX2__)
+        const __m256d one = _mm256_set1_pd(1.0), minus_two = _mm256_set1_pd(-2.0), two_pi = _mm256_set1_pd(2.0 * M_PI);
+        const __m256d vmean = _mm256_set1_pd(mean), vsigma = _mm256_set1_pd(sigma);
+
+        for (; i + 4 <= n; i += 4)
+        {
+            const __m256d r = _mm256_sqrt_pd(_mm256_mul_pd(minus_two, log(_mm256_sub_pd(one, _mm256_loadu_pd(u0 + i)))));
+
+            __m256d s, c;
+            sinCos(_mm256_mul_pd(two_pi, _mm256_loadu_pd(u1 + i)), s, c);
+
+            _mm256_storeu_pd(out + i, _mm256_add_pd(vmean, _mm256_mul_pd(_mm256_mul_pd(vsigma, r), c)));
+        }
+#endif
+        for (; i < n; i++)
+        {
+            out[i] = mean + sigma * std::sqrt(-2.0 * std::log(1.0 - u0[i])) * std::cos(2.0 * M_PI * u1[i]);
+        }
+    }
+}
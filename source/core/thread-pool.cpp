@@ -0,0 +1,107 @@
+#include "thread-pool.h"
+
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t num_threads)
+{
+    if (num_threads == 0) num_threads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        queues.push_back(std::make_unique<Queue>());
+    }
+
+    for (size_t i = 0; i < num_threads; i++)
+    {
+        threads.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stop = true;
+    }
+    wake.notify_all();
+
+    for (auto& thread : threads) thread.join();
+}
+
+void ThreadPool::parallelFor(size_t n, const std::function<void(size_t, size_t)>& f)
+{
+    if (n == 0) return;
+
+    job = &f;
+    remaining = n;
+
+    // Several small ranges per worker so that there is something left to steal
+    const size_t num_queues = queues.size();
+    const size_t chunk = std::max<size_t>(1, n / (num_queues * 8));
+
+    size_t worker = 0;
+    for (size_t begin = 0; begin < n; begin += chunk)
+    {
+        auto& queue = *queues[(worker++ * num_queues) / ((n + chunk - 1) / chunk)];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.ranges.push_back({ begin, std::min(begin + chunk, n) });
+    }
+
+    std::unique_lock<std::mutex> lock(mutex);
+    generation++;
+    wake.notify_all();
+    done.wait(lock, [this]() { return remaining == 0; });
+}
+
+void ThreadPool::work(size_t worker)
+{
+    size_t seen = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this, seen]() { return stop || generation != seen; });
+            if (stop) return;
+            seen = generation;
+        }
+
+        Range range;
+        while (pop(worker, range) || steal(worker, range))
+        {
+            for (size_t i = range.begin; i < range.end; i++) (*job)(i, worker);
+
+            size_t count = range.end - range.begin;
+            if (remaining.fetch_sub(count) == count)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                done.notify_all();
+            }
+        }
+    }
+}
+
+bool ThreadPool::pop(size_t worker, Range& range)
+{
+    auto& queue = *queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.ranges.empty()) return false;
+
+    range = queue.ranges.front();
+    queue.ranges.pop_front();
+    return true;
+}
+
+bool ThreadPool::steal(size_t worker, Range& range)
+{
+    for (size_t i = 1; i < queues.size(); i++)
+    {
+        auto& queue = *queues[(worker + i) % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.ranges.empty()) continue;
+
+        range = queue.ranges.back();
+        queue.ranges.pop_back();
+        return true;
+    }
+    return false;
+}
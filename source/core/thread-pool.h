@@ -0,0 +1,53 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+
+// Fixed set of worker threads with one task queue each. Workers take ranges from the
+// front of their own queue and steal from the back of other queues when it runs dry,
+// which balances loops where the cost per index varies a lot.
+class ThreadPool
+{
+public:
+    // 0 threads uses all hardware threads
+    explicit ThreadPool(size_t num_threads = 0);
+    ~ThreadPool();
+
+    size_t size() const { return threads.size(); }
+
+    // Calls f(index, worker) for every index in [0, n) and blocks until all are done
+    void parallelFor(size_t n, const std::function<void(size_t, size_t)>& f);
+
+private:
+    struct Range
+    {
+        size_t begin, end;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Range> ranges;
+    };
+
+    void work(size_t worker);
+    bool pop(size_t worker, Range& range);
+    bool steal(size_t worker, Range& range);
+
+    std::vector<std::thread> threads;
+    std::vector<std::unique_ptr<Queue>> queues;
+
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    size_t generation = 0;
+    bool stop = false;
+
+    const std::function<void(size_t, size_t)>* job = nullptr;
+    std::atomic<size_t> remaining = 0;
+};
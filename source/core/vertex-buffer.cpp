@@ -0,0 +1,201 @@
+#include "vertex-buffer.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+void Geometry::VertexBuffer::assign(const std::vector<Vec3>& vertices)
+{
+    x.resize(vertices.size());
+    y.resize(vertices.size());
+    z.resize(vertices.size());
+
+    for (size_t i = 0; i < vertices.size(); i++)
+    {
+        x[i] = vertices[i].x;
+        y[i] = vertices[i].y;
+        z[i] = vertices[i].z;
+    }
+
+    updateBounds();
+}
+
+void Geometry::Bounds::compute(const std::vector<Vec3>& vertices)
+{
+    if (vertices.empty())
+    {
+        *this = Bounds();
+        return;
+    }
+
+    min = max = vertices[0];
+    for (const auto& v : vertices)
+    {
+        min = Vec3(std::min(min.x, v.x), std::min(min.y, v.y), std::min(min.z, v.z));
+        max = Vec3(std::max(max.x, v.x), std::max(max.y, v.y), std::max(max.z, v.z));
+    }
+
+    const Vec3 center = (min + max) * 0.5;
+    double radius2 = 0.0;
+    for (const auto& v : vertices)
+    {
+        Vec3 d = v - center;
+        radius2 = std::max(radius2, d * d);
+    }
+
+    // Slightly enlarged so that rounding can't make the bounds tests disagree with the 
+    // per-vertex test for vertices very close to a plane
+    Vec3 margin = (max - min) * 1e-9 + Vec3(1e-12, 1e-12, 1e-12);
+    min -= margin;
+    max += margin;
+    radius = std::sqrt(radius2) + margin.length();
+}
+
+void Geometry::Bounds::compute(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z)
+{
+    if (x.empty())
+    {
+        *this = Bounds();
+        return;
+    }
+
+    min = max = Vec3(x[0], y[0], z[0]);
+    for (size_t i = 1; i < x.size(); i++)
+    {
+        min = Vec3(std::min(min.x, x[i]), std::min(min.y, y[i]), std::min(min.z, z[i]));
+        max = Vec3(std::max(max.x, x[i]), std::max(max.y, y[i]), std::max(max.z, z[i]));
+    }
+
+    const Vec3 center = (min + max) * 0.5;
+    double radius2 = 0.0;
+    for (size_t i = 0; i < x.size(); i++)
+    {
+        double dx = x[i] - center.x, dy = y[i] - center.y, dz = z[i] - center.z;
+        radius2 = std::max(radius2, dx * dx + dy * dy + dz * dz);
+    }
+
+    Vec3 margin = (max - min) * 1e-9 + Vec3(1e-12, 1e-12, 1e-12);
+    min -= margin;
+    max += margin;
+    radius = std::sqrt(radius2) + margin.length();
+}
+
+int Geometry::Bounds::side(const Vec3& normal, const Vec3& point, PlaneTestStats* stats, double tolerance) const
+{
+    const Vec3 center = (min + max) * 0.5;
+    const double d = normal * (center - point);
+
+    if (std::abs(d) > radius + tolerance)
+    {
+        if (stats) stats->sphere++;
+        return d > 0.0 ? 1 : -1;
+    }
+
+    const Vec3 extent = (max - min) * 0.5;
+    const double r = std::abs(normal.x) * extent.x + std::abs(normal.y) * extent.y + std::abs(normal.z) * extent.z;
+
+    if (std::abs(d) > r + tolerance)
+    {
+        if (stats) stats->box++;
+        return d > 0.0 ? 1 : -1;
+    }
+
+    if (stats) stats->vertices++;
+    return 0;
+}
+
+double Geometry::VertexBuffer::maxSquaredDistance(const Vec3& p) const
+{
+    double max_distance = 0.0;
+    for (size_t i = 0; i < size(); i++)
+    {
+        double dx = x[i] - p.x, dy = y[i] - p.y, dz = z[i] - p.z;
+        max_distance = std::max(max_distance, dx * dx + dy * dy + dz * dz);
+    }
+    return max_distance;
+}
+
+bool Geometry::intersects(const Vec3& normal, const Vec3& point, const VertexBuffer& vertices, bool& strictly_greater, PlaneTestStats* stats, double tolerance)
+{
+    bool greater = false, less = false;
+    strictly_greater = false;
+
+    if (vertices.size() == 0) return false;
+
+    if (int side = vertices.bounds.side(normal, point, stats, tolerance))
+    {
+        strictly_greater = side > 0;
+        return false;
+    }
+
+    // The bisector of coincident seeds has no normal, only the exact test can resolve it
+    if (tolerance > 0.0 && !(normal * normal > 0.0)) return true;
+
+    const size_t n = vertices.size();
+    size_t i = 0;
+
+    // A mixed result is passed on to the exact clipper anyway, only a result with all
+    // vertices on one side needs the nearest vertex to be outside the tolerance
+    double nearest = std::numeric_limits<double>::infinity();
+
+#if defined(__AVX2__)
+    // Distances are computed in the same order as Vec3 operations to give identical 
+    // results to the scalar path, so no fused multiply-add.
+    const __m256d nx = _mm256_set1_pd(normal.x), ny = _mm256_set1_pd(normal.y), nz = _mm256_set1_pd(normal.z);
+    const __m256d px = _mm256_set1_pd(point.x), py = _mm256_set1_pd(point.y), pz = _mm256_set1_pd(point.z);
+    const __m256d zero = _mm256_setzero_pd(), sign = _mm256_set1_pd(-0.0);
+    __m256d nearest4 = _mm256_set1_pd(nearest);
+
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256d dx = _mm256_sub_pd(_mm256_loadu_pd(&vertices.x[i]), px);
+        __m256d dy = _mm256_sub_pd(_mm256_loadu_pd(&vertices.y[i]), py);
+        __m256d dz = _mm256_sub_pd(_mm256_loadu_pd(&vertices.z[i]), pz);
+
+        __m256d d = _mm256_add_pd(_mm256_add_pd(_mm256_mul_pd(nx, dx), _mm256_mul_pd(ny, dy)), _mm256_mul_pd(nz, dz));
+
+        nearest4 = _mm256_min_pd(nearest4, _mm256_andnot_pd(sign, d));
+
+        int mask = _mm256_movemask_pd(_mm256_cmp_pd(d, zero, _CMP_GT_OQ));
+        if (mask != 0) greater = true;
+        if (mask != 0xF) less = true;
+
+        if (greater && less)
+        {
+            if (stats) stats->scanned += i + 4;
+            return true;
+        }
+    }
+
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, nearest4);
+    for (double lane : lanes) nearest = std::min(nearest, lane);
+#endif
+
+    for (; i < n; i++)
+    {
+        double d = normal * (Vec3(vertices.x[i], vertices.y[i], vertices.z[i]) - point);
+        if (d > 0.0)
+            greater = true;
+        else
+            less = true;
+
+        if (greater && less)
+        {
+            if (stats) stats->scanned += i + 1;
+            return true;
+        }
+
+        nearest = std::min(nearest, std::abs(d));
+    }
+
+    if (stats) stats->scanned += n;
+
+    if (nearest <= tolerance && tolerance > 0.0) return true;
+
+    strictly_greater = greater && !less;
+    return false;
+}
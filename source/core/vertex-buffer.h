@@ -0,0 +1,84 @@
+#pragma once
+
+#include <vector>
+
+#include "geometry.h"
+
+namespace Geometry
+{
+    // Number of planes resolved by each test tier, vertices visited by the per vertex
+    // tier and planes that actually cut a mesh
+    struct PlaneTestStats
+    {
+        PlaneTestStats& operator+=(const PlaneTestStats& s)
+        {
+            sphere += s.sphere;
+            box += s.box;
+            vertices += s.vertices;
+            scanned += s.scanned;
+            clipped += s.clipped;
+            return *this;
+        }
+
+        PlaneTestStats operator-(const PlaneTestStats& s) const
+        {
+            return { sphere - s.sphere, box - s.box, vertices - s.vertices, scanned - s.scanned, clipped - s.clipped };
+        }
+
+        size_t tested() const { return sphere + box + vertices; }
+        size_t earlyOuts() const { return sphere + box; }
+
+        size_t sphere = 0, box = 0, vertices = 0;
+        size_t scanned = 0, clipped = 0;
+    };
+
+    // Conservative bounding box and bounding sphere around the box center
+    struct Bounds
+    {
+        void compute(const std::vector<Vec3>& vertices);
+        void compute(const std::vector<double>& x, const std::vector<double>& y, const std::vector<double>& z);
+
+        // Classifies the plane in O(1) if possible. Returns 1 if all points are above the
+        // plane, -1 if no point is above it and 0 if the plane may cut the bounds. Points
+        // closer to the plane than tolerance count as cutting.
+        int side(const Vec3& normal, const Vec3& point, PlaneTestStats* stats = nullptr, double tolerance = 0.0) const;
+
+        // Largest absolute coordinate
+        double magnitude() const { return std::max(min.maxAbs(), max.maxAbs()); }
+
+        Vec3 min, max;
+        double radius = 0.0;
+    };
+
+    // Vertex positions in structure of arrays layout, so that plane side tests can 
+    // process several vertices per instruction. Refreshed when the mesh changes.
+    struct VertexBuffer
+    {
+        VertexBuffer() = default;
+        explicit VertexBuffer(const std::vector<Vec3>& vertices) { assign(vertices); }
+
+        void assign(const std::vector<Vec3>& vertices);
+
+        // Recomputes bounds after writing to x, y and z directly
+        void updateBounds() { bounds.compute(x, y, z); }
+
+        size_t size() const { return x.size(); }
+
+        double maxSquaredDistance(const Vec3& p) const;
+
+        std::vector<double> x, y, z;
+
+        Bounds bounds;
+    };
+
+    // Same as Plane::intersects, for the plane through point with unit normal. Planes that 
+    // clearly miss or contain the bounds are resolved without visiting the vertices. Vertices
+    // within tolerance of the plane can't be classified reliably and count as an intersection,
+    // which leaves the exact decision to the clipper.
+    bool intersects(const Vec3& normal, const Vec3& point, const VertexBuffer& vertices, bool& strictly_greater, PlaneTestStats* stats = nullptr, double tolerance = 0.0);
+
+    inline bool intersects(const Plane& plane, const VertexBuffer& vertices, bool& strictly_greater, PlaneTestStats* stats = nullptr)
+    {
+        return intersects(plane.normal, plane.point, vertices, strictly_greater, stats, plane.errorBound(vertices.bounds.magnitude()));
+    }
+}
@@ -0,0 +1,133 @@
+#include "voronoi-cell.h"
+
+#include <algorithm>
+
+namespace
+{
+    bool coincident(const Geometry::Vec3& a, const Geometry::Vec3& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+}
+
+void Geometry::CellBuilder::build(const KdTree<Vec3>& seeds, size_t seed, const Vec3& min, const Vec3& max, VoronoiCell& cell)
+{
+    const Vec3& p0 = seeds.points()[seed];
+
+    cell.clear();
+    boxMesh(min, max, cell_mesh);
+
+    cell_bounds.compute(cell_mesh.vertices);
+
+    // The cell is contained in a sphere around p0 with this radius, a bisector plane is
+    // at half the distance to its seed and can't cut the cell if beyond the sphere
+    double radius2 = maxSquaredDistance(cell_mesh, p0);
+
+    // Of coincident seeds only the one with the lowest index gets a cell, and faces towards
+    // them are tagged with it. Copies of a point are at the same distance, so they are
+    // found among the neighbours at the distance of the last one.
+    ties.clear();
+    double tie_distance2 = -1.0;
+
+    size_t i;
+    double distance2;
+    neighbours.reset(seeds, p0);
+    while (neighbours.next(i, distance2))
+    {
+        if (i == seed) continue;
+
+        if (distance2 > 4.0 * radius2) break;
+
+        const Vec3& p1 = seeds.points()[i];
+        if (coincident(p0, p1))
+        {
+            if (i > seed) continue;
+
+            cell_mesh.clear();
+            break;
+        }
+
+        if (distance2 != tie_distance2)
+        {
+            ties.clear();
+            tie_distance2 = distance2;
+        }
+
+        auto tie = std::find_if(ties.begin(), ties.end(), [&](size_t t) { return coincident(seeds.points()[t], p1); });
+        if (tie != ties.end())
+        {
+            // The plane was already applied, only the tag may have to change
+            if (i < *tie)
+            {
+                std::replace(cell_mesh.polygon_tags.begin(), cell_mesh.polygon_tags.end(), (int)*tie, (int)i);
+                *tie = i;
+            }
+            continue;
+        }
+        ties.push_back(i);
+
+        Plane plane = getBisectorPlane(p0, p1, (int)seed, (int)i);
+
+        // Planes that straddle the bounds are tested per vertex by the clipper
+        int side = cell_bounds.side(plane.normal, plane.point, &stats, plane.errorBound(cell_bounds.magnitude()));
+        if (side < 0) continue;
+
+        if (side > 0)
+        {
+            cell_mesh.clear();
+            break;
+        }
+
+        if (cell_clipper.clipAndCap(cell_mesh, plane, (int)i))
+        {
+            stats.clipped++;
+            if (cell_mesh.empty()) break;
+        }
+
+        cell_bounds.compute(cell_mesh.vertices);
+        radius2 = maxSquaredDistance(cell_mesh, p0);
+    }
+
+    // Reuses the buffers of the cell if it is scratch data of a worker as well
+    cell.mesh = cell_mesh;
+
+    // Planes may have been clipped away entirely by later planes, only keep actual faces
+    for (int tag : cell.mesh.polygon_tags)
+    {
+        if (tag < 0 || std::find(cell.neighbours.begin(), cell.neighbours.end(), tag) != cell.neighbours.end()) continue;
+
+        cell.planes.push_back(getBisectorPlane(p0, seeds.points()[tag], (int)seed, tag));
+        cell.neighbours.push_back(tag);
+    }
+}
+
+bool Geometry::CellBuilder::intersect(const Mesh& source, const VoronoiCell& cell, Mesh& fragment)
+{
+    fragment.clear();
+    if (cell.mesh.empty()) return false;
+
+    Mesh& mesh = fragment_mesh;
+    mesh = source;
+    vertices.assign(mesh.vertices);
+
+    for (size_t i = 0; i < cell.planes.size(); i++)
+    {
+        bool is_clipped;
+        if (!Geometry::intersects(cell.planes[i], vertices, is_clipped, &stats))
+        {
+            if (is_clipped) return false;
+            continue;
+        }
+
+        // The buffer only needs refreshing when the fragment changed
+        if (clipper.clipAndCap(mesh, cell.planes[i], cell.neighbours[i]))
+        {
+            stats.clipped++;
+            vertices.assign(mesh.vertices);
+        }
+    }
+
+    // The fragment only gets the capacity it needs, which adds up over many fragments
+    fragment = mesh;
+    return !fragment.empty();
+}
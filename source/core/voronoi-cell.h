@@ -0,0 +1,57 @@
+#pragma once
+
+#include <vector>
+
+#include "geometry.h"
+#include "mesh-clip.h"
+#include "kd-tree.h"
+#include "vertex-buffer.h"
+
+namespace Geometry
+{
+    // Convex Voronoi cell of a seed point, bounded by an axis aligned box
+    struct VoronoiCell
+    {
+        void clear()
+        {
+            mesh.clear();
+            planes.clear();
+            neighbours.clear();
+        }
+
+        Mesh mesh;
+
+        // Bisector planes that contribute a face to the cell and the seed on their other side
+        std::vector<Plane> planes;
+        std::vector<int> neighbours;
+    };
+
+    // Clipping happens in scratch meshes owned by the builder, each with its own clipper, and
+    // only finished cells and fragments are copied out. One builder per worker therefore stops
+    // allocating once its buffers fit the largest cell and fragment.
+    class CellBuilder
+    {
+    public:
+        // Builds the cell of seeds[seed] by clipping the box with bisector planes of
+        // increasingly distant seeds, until no remaining bisector can reach the cell. The cell
+        // is empty if a seed with a lower index lies at the same point.
+        void build(const KdTree<Vec3>& seeds, size_t seed, const Vec3& min, const Vec3& max, VoronoiCell& cell);
+
+        // Sets fragment to the intersection of source with the convex cell. Returns false if
+        // nothing remains.
+        bool intersect(const Mesh& source, const VoronoiCell& cell, Mesh& fragment);
+
+        // Accumulated over all build and intersect calls
+        PlaneTestStats stats;
+
+    private:
+        MeshClipper cell_clipper, clipper;
+        Mesh cell_mesh, fragment_mesh;
+
+        KdTree<Vec3>::Query neighbours;
+        std::vector<size_t> ties;
+
+        VertexBuffer vertices;
+        Bounds cell_bounds;
+    };
+}
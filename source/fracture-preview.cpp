@@ -0,0 +1,333 @@
+#include "fracture-preview.h"
+
+#include <maya/MPlug.h>
+#include <maya/MDataBlock.h>
+#include <maya/MDataHandle.h>
+#include <maya/MArrayDataHandle.h>
+#include <maya/MFnTypedAttribute.h>
+#include <maya/MFnNumericAttribute.h>
+#include <maya/MFnEnumAttribute.h>
+#include <maya/MFnMatrixAttribute.h>
+#include <maya/MFnMesh.h>
+#include <maya/MFnNurbsCurve.h>
+#include <maya/MFnVectorArrayData.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MDagPath.h>
+#include <maya/MUserData.h>
+#include <maya/MDrawContext.h>
+#include <maya/MUIDrawManager.h>
+#include <maya/MHWGeometryUtilities.h>
+
+#include "point-distribution.h"
+#include "util.h"
+#include "core/fracture.h"
+
+// Within the range Autodesk reserves for plugins that are not distributed
+const MTypeId FracturePreview::id(0x0007F4A0);
+const MString FracturePreview::draw_db_classification("drawdb/geometry/fracturePreview");
+const MString FracturePreview::draw_registrant_id("fracturePreview");
+
+MObject FracturePreview::in_mesh;
+MObject FracturePreview::in_mesh_matrix;
+MObject FracturePreview::seed_source;
+MObject FracturePreview::sphere_matrix;
+MObject FracturePreview::sphere_radius;
+MObject FracturePreview::in_curves;
+MObject FracturePreview::in_positions;
+MObject FracturePreview::num_fragments;
+MObject FracturePreview::seed;
+MObject FracturePreview::min_distance;
+MObject FracturePreview::curve_radius;
+MObject FracturePreview::disk_axis;
+MObject FracturePreview::steps;
+MObject FracturePreview::step_noise;
+MObject FracturePreview::num_cells;
+
+FracturePreview::FracturePreview() : pool(0) {};
+
+FracturePreview::~FracturePreview() {};
+
+MStatus FracturePreview::compute(const MPlug& plug, MDataBlock& data)
+{
+    if (plug != num_cells) return MS::kUnknownParameter;
+
+    std::vector<Geometry::Vec3> cell_lines;
+    MBoundingBox cell_bounds;
+    int count = 0;
+
+    // Like the command, the object space bounds of the mesh transformed by its world matrix
+    MObject mesh_data = data.inputValue(in_mesh).asMesh();
+    if (!mesh_data.isNull())
+    {
+        MPointArray points;
+        MFnMesh(mesh_data).getPoints(points);
+
+        MBoundingBox BB;
+        for (unsigned int i = 0; i < points.length(); i++) BB.expand(points[i]);
+        BB.transformUsing(data.inputValue(in_mesh_matrix).asMatrix());
+
+        const Geometry::Vec3 min = toVec3(BB.min()), max = toVec3(BB.max());
+
+        const size_t num = (size_t)data.inputValue(num_fragments).asInt();
+        const uint64_t random_seed = (uint64_t)data.inputValue(seed).asInt();
+
+        std::vector<Geometry::Vec3> seeds;
+        switch (data.inputValue(seed_source).asShort())
+        {
+        case SPHERE:
+            seeds = PointDistribution::implicitSphere(
+                data.inputValue(sphere_matrix).asMatrix(), data.inputValue(sphere_radius).asDouble(),
+                data.inputValue(disk_axis).asShort(), data.inputValue(steps).asInt(),
+                std::max(data.inputValue(step_noise).asDouble(), 1e-6), num, random_seed, &pool
+            );
+            break;
+        case CURVES:
+        {
+            std::vector<PointDistribution::CurveTable> curves;
+
+            MArrayDataHandle curves_handle = data.inputArrayValue(in_curves);
+            for (unsigned int i = 0; i < curves_handle.elementCount(); i++, curves_handle.next())
+            {
+                MObject curve_data = curves_handle.inputValue().asNurbsCurve();
+                if (!curve_data.isNull()) curves.push_back(PointDistribution::sampleCurve(MFnNurbsCurve(curve_data), 32, MSpace::kObject));
+            }
+
+            seeds = PointDistribution::curves(curves, data.inputValue(curve_radius).asDouble(), num, random_seed, &pool);
+            break;
+        }
+        case PARTICLES:
+        {
+            MObject positions_data = data.inputValue(in_positions).data();
+            if (!positions_data.isNull()) seeds = PointDistribution::particles(MFnVectorArrayData(positions_data).array());
+            break;
+        }
+        default:
+            seeds = PointDistribution::uniformBoundingBox(min, max, num, random_seed, &pool);
+        }
+
+        seeds = PointDistribution::removeDuplicates(seeds, data.inputValue(min_distance).asDouble());
+
+        // Every edge of a closed cell is shared by two polygons in opposite directions,
+        // so only the one from the lower to the higher index is drawn
+        for (const auto& cell : Fracture::buildCells(seeds, min, max, pool))
+        {
+            if (cell.mesh.empty()) continue;
+            count++;
+
+            const Geometry::Mesh& mesh = cell.mesh;
+            size_t offset = 0;
+            for (int polygon_count : mesh.polygon_counts)
+            {
+                for (int j = 0; j < polygon_count; j++)
+                {
+                    int a = mesh.polygon_connects[offset + j];
+                    int b = mesh.polygon_connects[offset + (j + 1) % polygon_count];
+                    if (a > b) continue;
+
+                    cell_lines.push_back(mesh.vertices[a]);
+                    cell_lines.push_back(mesh.vertices[b]);
+                }
+                offset += polygon_count;
+            }
+        }
+
+        cell_bounds = BB;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        lines.swap(cell_lines);
+        bounds = cell_bounds;
+        version++;
+    }
+
+    MDataHandle out = data.outputValue(num_cells);
+    out.setInt(count);
+    out.setClean();
+
+    return MS::kSuccess;
+}
+
+bool FracturePreview::isBounded() const
+{
+    return true;
+}
+
+// Lines are in world space, the bounds of a locator in its object space
+MBoundingBox FracturePreview::boundingBox() const
+{
+    MDagPath path;
+    MDagPath::getAPathTo(thisMObject(), path);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    MBoundingBox box = bounds;
+    box.transformUsing(path.inclusiveMatrixInverse());
+    return box;
+}
+
+bool FracturePreview::getLines(std::vector<Geometry::Vec3>& lines, size_t& version) const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (version == this->version) return false;
+
+    lines = this->lines;
+    version = this->version;
+    return true;
+}
+
+void* FracturePreview::creator()
+{
+    return new FracturePreview();
+}
+
+MStatus FracturePreview::initialize()
+{
+    MFnTypedAttribute typed;
+    MFnNumericAttribute numeric;
+    MFnEnumAttribute enumeration;
+    MFnMatrixAttribute matrix;
+
+    in_mesh = typed.create("inMesh", "inm", MFnData::kMesh);
+
+    in_mesh_matrix = matrix.create("inMeshMatrix", "imm");
+
+    seed_source = enumeration.create("seedSource", "sso", BOUNDING_BOX);
+    enumeration.addField("boundingBox", BOUNDING_BOX);
+    enumeration.addField("sphere", SPHERE);
+    enumeration.addField("curves", CURVES);
+    enumeration.addField("particles", PARTICLES);
+
+    sphere_matrix = matrix.create("sphereMatrix", "sma");
+
+    sphere_radius = numeric.create("sphereRadius", "sra", MFnNumericData::kDouble, 1.0);
+
+    in_curves = typed.create("inCurves", "icv", MFnData::kNurbsCurve);
+    typed.setArray(true);
+    typed.setDisconnectBehavior(MFnAttribute::kDelete);
+
+    in_positions = typed.create("inPositions", "ipo", MFnData::kVectorArray);
+
+    num_fragments = numeric.create("numFragments", "nfr", MFnNumericData::kInt, 5);
+    numeric.setMin(1);
+
+    seed = numeric.create("seed", "sdv", MFnNumericData::kInt, 1);
+    numeric.setMin(1);
+
+    min_distance = numeric.create("minDistance", "mdi", MFnNumericData::kDouble, 0.0);
+    numeric.setMin(0.0);
+
+    curve_radius = numeric.create("curveRadius", "cra", MFnNumericData::kDouble, 0.1);
+    numeric.setMin(0.0);
+
+    disk_axis = enumeration.create("diskAxis", "dax", 0);
+    enumeration.addField("none", 0);
+    enumeration.addField("x", 1);
+    enumeration.addField("y", 2);
+    enumeration.addField("z", 3);
+
+    steps = numeric.create("steps", "stp", MFnNumericData::kInt, 0);
+    numeric.setMin(0);
+
+    step_noise = numeric.create("stepNoise", "sno", MFnNumericData::kDouble, 0.05);
+    numeric.setMin(0.0);
+
+    num_cells = numeric.create("numCells", "ncl", MFnNumericData::kInt, 0);
+    numeric.setWritable(false);
+    numeric.setStorable(false);
+
+    const MObject inputs[] = {
+        in_mesh, in_mesh_matrix, seed_source, sphere_matrix, sphere_radius, in_curves, in_positions,
+        num_fragments, seed, min_distance, curve_radius, disk_axis, steps, step_noise
+    };
+
+    MStatus status = addAttribute(num_cells);
+    for (const MObject& input : inputs)
+    {
+        if (!status) break;
+        status = addAttribute(input);
+        if (status) status = attributeAffects(input, num_cells);
+    }
+
+    return status;
+}
+
+namespace
+{
+    // Cell edges in the object space of the locator, refreshed when the node recomputes or moves
+    class PreviewData : public MUserData
+    {
+    public:
+        PreviewData() : MUserData(false) { }
+
+        std::vector<Geometry::Vec3> lines;
+        size_t version = ~(size_t)0;
+
+        MPointArray points;
+        MMatrix M_inv;
+    };
+}
+
+FracturePreviewDrawOverride::FracturePreviewDrawOverride(const MObject& object)
+    : MHWRender::MPxDrawOverride(object, nullptr) { }
+
+MHWRender::MPxDrawOverride* FracturePreviewDrawOverride::creator(const MObject& object)
+{
+    return new FracturePreviewDrawOverride(object);
+}
+
+MHWRender::DrawAPI FracturePreviewDrawOverride::supportedDrawAPIs() const
+{
+    return MHWRender::kAllDevices;
+}
+
+bool FracturePreviewDrawOverride::isBounded(const MDagPath& object_path, const MDagPath& camera_path) const
+{
+    return true;
+}
+
+MBoundingBox FracturePreviewDrawOverride::boundingBox(const MDagPath& object_path, const MDagPath& camera_path) const
+{
+    const FracturePreview* preview = static_cast<const FracturePreview*>(MFnDependencyNode(object_path.node()).userNode());
+    return preview ? preview->boundingBox() : MBoundingBox();
+}
+
+MUserData* FracturePreviewDrawOverride::prepareForDraw(const MDagPath& object_path, const MDagPath& camera_path,
+    const MHWRender::MFrameContext& frame_context, MUserData* old_data)
+{
+    PreviewData* data = dynamic_cast<PreviewData*>(old_data);
+    if (!data) data = new PreviewData();
+
+    const MObject node = object_path.node();
+    const FracturePreview* preview = static_cast<const FracturePreview*>(MFnDependencyNode(node).userNode());
+    if (!preview) return data;
+
+    // Pulling the output recomputes the cells if any input changed
+    MPlug(node, FracturePreview::num_cells).asInt();
+
+    const bool changed = preview->getLines(data->lines, data->version);
+
+    const MMatrix M_inv = object_path.inclusiveMatrixInverse();
+    if (!changed && M_inv == data->M_inv) return data;
+
+    const auto& lines = data->lines;
+    data->points.setLength((unsigned)lines.size());
+    for (unsigned int i = 0; i < lines.size(); i++)
+    {
+        data->points[i] = MPoint(lines[i].x, lines[i].y, lines[i].z) * M_inv;
+    }
+    data->M_inv = M_inv;
+
+    return data;
+}
+
+void FracturePreviewDrawOverride::addUIDrawables(const MDagPath& object_path, MHWRender::MUIDrawManager& draw_manager,
+    const MHWRender::MFrameContext& frame_context, const MUserData* data)
+{
+    const PreviewData* preview = dynamic_cast<const PreviewData*>(data);
+    if (!preview || preview->points.length() == 0) return;
+
+    draw_manager.beginDrawable();
+    draw_manager.setColor(MHWRender::MGeometryUtilities::wireframeColor(object_path));
+    draw_manager.mesh(MHWRender::MUIDrawManager::kLines, preview->points);
+    draw_manager.endDrawable();
+}
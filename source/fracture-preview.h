@@ -0,0 +1,94 @@
+#pragma once
+
+#include <vector>
+#include <mutex>
+
+#include <maya/MPxLocatorNode.h>
+#include <maya/MPxDrawOverride.h>
+#include <maya/MTypeId.h>
+#include <maya/MString.h>
+#include <maya/MBoundingBox.h>
+#include <maya/MPointArray.h>
+
+#include "core/geometry.h"
+#include "core/thread-pool.h"
+
+// Locator that draws the Voronoi cells of the seeds the voronoiFracture command would use,
+// bounded by the same box as the command, the object space bounding box of the input mesh
+// transformed to world space. Only the cells are built, the mesh itself
+// is not clipped, so the preview updates at interactive rates while parameters change.
+// Running the command with the same parameters and -seed creates the previewed fracture.
+class FracturePreview : public MPxLocatorNode
+{
+public:
+    FracturePreview();
+    ~FracturePreview() override;
+
+    MStatus compute(const MPlug& plug, MDataBlock& data) override;
+
+    bool isBounded() const override;
+    MBoundingBox boundingBox() const override;
+
+    static void* creator();
+    static MStatus initialize();
+
+    // Copies the cell edges in world space as pairs of points, unless version already is the
+    // number of the last compute. Returns false if nothing changed.
+    bool getLines(std::vector<Geometry::Vec3>& lines, size_t& version) const;
+
+    static const MTypeId id;
+    static const MString draw_db_classification;
+    static const MString draw_registrant_id;
+
+    enum SeedSource { BOUNDING_BOX, SPHERE, CURVES, PARTICLES };
+
+    // Inputs, matching the flags of the command
+    static MObject in_mesh;
+    static MObject in_mesh_matrix;
+    static MObject seed_source;
+    static MObject sphere_matrix;
+    static MObject sphere_radius;
+    static MObject in_curves;
+    static MObject in_positions;
+    static MObject num_fragments;
+    static MObject seed;
+    static MObject min_distance;
+    static MObject curve_radius;
+    static MObject disk_axis;
+    static MObject steps;
+    static MObject step_noise;
+
+    // Number of cells, pulled by the draw override to trigger compute
+    static MObject num_cells;
+
+private:
+    // Kept for the lifetime of the node, so recomputing doesn't start threads
+    ThreadPool pool;
+
+    mutable std::mutex mutex;
+    std::vector<Geometry::Vec3> lines;
+    MBoundingBox bounds;
+    size_t version = 0;
+};
+
+class FracturePreviewDrawOverride : public MHWRender::MPxDrawOverride
+{
+public:
+    static MHWRender::MPxDrawOverride* creator(const MObject& object);
+
+    MHWRender::DrawAPI supportedDrawAPIs() const override;
+
+    bool isBounded(const MDagPath& object_path, const MDagPath& camera_path) const override;
+    MBoundingBox boundingBox(const MDagPath& object_path, const MDagPath& camera_path) const override;
+
+    MUserData* prepareForDraw(const MDagPath& object_path, const MDagPath& camera_path,
+        const MHWRender::MFrameContext& frame_context, MUserData* old_data) override;
+
+    bool hasUIDrawables() const override { return true; }
+
+    void addUIDrawables(const MDagPath& object_path, MHWRender::MUIDrawManager& draw_manager,
+        const MHWRender::MFrameContext& frame_context, const MUserData* data) override;
+
+private:
+    explicit FracturePreviewDrawOverride(const MObject& object);
+};
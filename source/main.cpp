@@ -2,6 +2,7 @@
 #include <maya/MStatus.h>
 #include <maya/MFnPlugin.h>
 #include <maya/MGlobal.h>
+#include <maya/MDrawRegistry.h>
 
 #include "scripts/initializeUI.py"
 #include "scripts/uninitializeUI.py"
@@ -10,6 +11,7 @@
 #include "scripts/utilities.py"
 
 #include "voronoi-fracture.h"
+#include "fracture-preview.h"
 
 MStatus initializePlugin(MObject obj)
 {
@@ -22,6 +24,31 @@ MStatus initializePlugin(MObject obj)
         return status;
     }
 
+    status = VoronoiFracture::addCallbacks();
+    if (!status)
+    {
+        status.perror("addCallbacks");
+        return status;
+    }
+
+    status = plugin.registerNode("fracturePreview", FracturePreview::id, FracturePreview::creator, FracturePreview::initialize,
+        MPxNode::kLocatorNode, &FracturePreview::draw_db_classification);
+
+    if (!status)
+    {
+        status.perror("registerNode");
+        return status;
+    }
+
+    status = MHWRender::MDrawRegistry::registerDrawOverrideCreator(FracturePreview::draw_db_classification,
+        FracturePreview::draw_registrant_id, FracturePreviewDrawOverride::creator);
+
+    if (!status)
+    {
+        status.perror("registerDrawOverrideCreator");
+        return status;
+    }
+
     // Create UI menu
     status = MGlobal::executePythonCommand(
         (std::string(menu) + createFractureUI + initialize_UI).c_str()
@@ -38,6 +65,8 @@ MStatus uninitializePlugin(MObject obj)
 {
     MFnPlugin plugin(obj);
 
+    VoronoiFracture::removeCallbacks();
+
     MStatus status = plugin.deregisterCommand("voronoiFracture");
     if (!status)
     {
@@ -45,6 +74,20 @@ MStatus uninitializePlugin(MObject obj)
         return status;
     }
 
+    status = MHWRender::MDrawRegistry::deregisterDrawOverrideCreator(FracturePreview::draw_db_classification, FracturePreview::draw_registrant_id);
+    if (!status)
+    {
+        status.perror("deregisterDrawOverrideCreator");
+        return status;
+    }
+
+    status = plugin.deregisterNode(FracturePreview::id);
+    if (!status)
+    {
+        status.perror("deregisterNode");
+        return status;
+    }
+
     // Remove UI Window
     status = MGlobal::executePythonCommand(uninitialize_UI);
 
@@ -1,187 +1,84 @@
 #include "point-distribution.h"
 
-#include <array>
-
 #include <maya/MFnNurbsCurve.h>
 #include <maya/MVector.h>
-#include <maya/MQuaternion.h>
 #include <maya/MFnParticleSystem.h>
 #include <maya/MVectorArray.h>
+#include <maya/MTransformationMatrix.h>
 #include "util.h"
 
-std::vector<MPoint> PointDistribution::uniformBoundingBox(const MPoint& min, const MPoint& max, size_t num)
-{
-    std::uniform_real_distribution<double> x_dist(min.x, max.x), y_dist(min.y, max.y), z_dist(min.z, max.z);
-
-    std::vector<MPoint> points(num);
-
-    for (auto& p : points)
-    {
-        p = MPoint(x_dist(engine), y_dist(engine), z_dist(engine));
-    }
-
-    return points;
-}
-
-std::vector<MPoint> PointDistribution::sphereQuadratic(const MPoint& position, const std::array<MVector, 3> &axes, size_t num)
-{
-    std::vector<MPoint> points(num, position);
-
-    for (auto& p : points)
-    {
-        double theta = theta_dist(engine);
-        double phi = phi_dist(engine);
-        double r = unit_dist(engine);
-
-        p += std::sin(theta) * std::cos(phi) * axes[0] * r;
-        p += std::sin(theta) * std::sin(phi) * axes[1] * r;
-        p += std::cos(theta) * axes[2] * r;
-    }
-
-    return points;
-}
+#include <algorithm>
+#include <array>
 
-std::vector<MPoint> PointDistribution::diskQuadratic(const MPoint& position, const std::array<MVector, 3>& axes, size_t axis, size_t num)
+PointDistribution::CurveTable PointDistribution::sampleCurve(const MFnNurbsCurve& curve, size_t samples_per_span, MSpace::Space space)
 {
-    unsigned idx = axis - 1;
-    unsigned idx0 = std::min(idx - 1u, 2u); // relies on unsigned wrap-around
-    unsigned idx1 = idx + 1 > 2 ? 0 : idx + 1;
+    double start, end;
+    curve.getKnotDomain(start, end);
 
-    std::vector<MPoint> points(num, position);
+    // Evaluating at a parameter is direct, unlike finding the parameter at a length
+    const size_t num = std::max((size_t)std::max(curve.numSpans(), 1) * samples_per_span, (size_t)64);
 
-    for (auto& p : points)
+    CurveTable table;
+    for (size_t i = 0; i <= num; i++)
     {
-        double phi = phi_dist(engine);
-        double r = unit_dist(engine);
-
-        p += std::cos(phi) * r * axes[idx0];
-        p += std::sin(phi) * r * axes[idx1];
-    }
-
-    return points;
-}
-
-std::vector<MPoint> PointDistribution::diskSteps(const MPoint& position, const std::array<MVector, 3>& axes, size_t steps, size_t axis, double noise_sigma, size_t num)
-{
-    size_t step_points = num / steps;
-    unsigned idx = axis - 1;
-    unsigned idx0 = std::min(idx - 1u, 2u);
-    unsigned idx1 = idx + 1 > 2 ? 0 : idx + 1;
-
-    std::normal_distribution<double> noise(1, noise_sigma);
+        double t = start + (end - start) * i / num;
 
-    std::vector<MPoint> points(step_points * steps, position);
+        MPoint point;
+        curve.getPointAtParam(t, point, space);
+        MVector tangent = curve.tangent(t, space);
 
-    size_t p_idx = 0;
-    for (size_t s = 1; s <= steps; s++)
-    {
-        double r = s / (double)steps;
-        for (size_t sp = 0; sp < step_points; sp++)
-        {
-            double phi = (sp / (double)step_points) * 2.0 * M_PI;
-
-            auto& p = points[p_idx++];
-            p += std::cos(phi) * r * noise(engine) * axes[idx0];
-            p += std::sin(phi) * r * noise(engine) * axes[idx1];
-        }
+        table.add(toVec3(point), toVec3(tangent));
     }
 
-    return points;
+    return table;
 }
 
-std::vector<MPoint> PointDistribution::sphereSteps(const MPoint& position, const std::array<MVector, 3>& axes, size_t steps, double noise_sigma, size_t num)
+std::vector<Geometry::Vec3> PointDistribution::implicitSphere(const MMatrix& M, double radius, unsigned disk_axis, unsigned steps, double step_noise, size_t num, uint64_t seed, ThreadPool* pool)
 {
-    // num / steps = phi_steps * theta_steps = phi_steps * phi_steps * 0.5 <=>
-    double d_phi_steps = std::sqrt(2.0 * num / steps);
-    size_t phi_steps = (size_t)d_phi_steps;
-    size_t theta_steps = (size_t)(d_phi_steps * 0.5);
-
-    std::normal_distribution<double> noise(1, noise_sigma);
+    Geometry::Vec3 position = toVec3(MTransformationMatrix(M).getTranslation(MSpace::kWorld));
 
-    std::vector<MPoint> points(steps * phi_steps * theta_steps, position);
+    MTransformationMatrix axes_transform(M);
+    axes_transform.setTranslation(MVector(0, 0, 0), MSpace::kWorld);
+    MMatrix M_axes = axes_transform.asMatrix();
 
-    phi_steps++;
-    theta_steps++;
+    std::array<Geometry::Vec3, 3> axes = {
+        toVec3(MVector(radius, 0, 0) * M_axes),
+        toVec3(MVector(0, radius, 0) * M_axes),
+        toVec3(MVector(0, 0, radius) * M_axes)
+    };
 
-    size_t p_idx = 0;
-    for (size_t step_idx = 1; step_idx <= steps; step_idx++)
+    if (disk_axis == 0)
     {
-        double r = step_idx / (double)steps;
-        for (size_t phi_idx = 1; phi_idx < phi_steps; phi_idx++)
-        {
-            double phi = 2.0 * M_PI * (phi_idx / (double)phi_steps);
-            for (size_t theta_idx = 1; theta_idx < theta_steps; theta_idx++)
-            {
-                double theta = M_PI * (theta_idx / (double)theta_steps);
-                auto& p = points.at(p_idx++);
-                p += std::sin(theta) * std::cos(phi) * axes[0] * r * noise(engine);
-                p += std::sin(theta) * std::sin(phi) * axes[1] * r * noise(engine);
-                p += std::cos(theta) * axes[2] * r * noise(engine);
-            }
-        }
+        if (steps == 0)
+            return sphereQuadratic(position, axes, num, seed, pool);
+        else
+            return sphereSteps(position, axes, steps, step_noise, num, seed, pool);
     }
-
-    return points;
-}
-
-std::vector<MPoint> PointDistribution::curve(const MFnNurbsCurve& curve, double radius, size_t num)
-{
-    std::uniform_real_distribution<double> length_dist(0.0, curve.length(1e-6));
-
-    std::vector<MPoint> points(num);
-
-    for (auto& p : points)
+    else
     {
-        double t = curve.findParamFromLength(length_dist(engine));
-        MPoint point;
-        curve.getPointAtParam(t, point, MSpace::kWorld);
-
-        MVector tangent = curve.tangent(t);
-        MVector normal = orthogonalUnitVector(tangent);
-
-        MQuaternion quat(phi_dist(engine), tangent);
-        MVector direction = normal.rotateBy(quat);
-
-        double r = unit_dist(engine) * radius;
-
-        p = point + direction * r;
+        if (steps == 0)
+            return diskQuadratic(position, axes, disk_axis, num, seed, pool);
+        else
+            return diskSteps(position, axes, steps, disk_axis, step_noise, num, seed, pool);
     }
-
-    return points;
 }
 
-std::vector<MPoint> PointDistribution::particles(const MFnParticleSystem& particles)
+std::vector<Geometry::Vec3> PointDistribution::particles(const MFnParticleSystem& particles)
 {
     MVectorArray positions;
     particles.position(positions);
 
-    std::vector<MPoint> points(positions.length());
-
-    for (unsigned int i = 0; i < positions.length(); i++)
-    {
-        points[i] = positions[i];
-    }
-
-    return points;
+    return PointDistribution::particles(positions);
 }
 
-std::vector<MPoint> PointDistribution::removeDuplicates(const std::vector<MPoint>& points, double tolerance)
+std::vector<Geometry::Vec3> PointDistribution::particles(const MVectorArray& positions)
 {
-    std::vector<MPoint> new_points;
+    std::vector<Geometry::Vec3> points(positions.length());
 
-    for (const auto& p0 : points)
+    for (unsigned int i = 0; i < positions.length(); i++)
     {
-        bool add = true;
-        for (const auto& p1 : new_points)
-        {
-            if (p0.distanceTo(p1) < tolerance)
-            {
-                add = false;
-                break;
-            }
-        }
-        if (add) new_points.push_back(p0);
+        points[i] = toVec3(positions[i]);
     }
 
-    return new_points;
-}
\ No newline at end of file
+    return points;
+}
@@ -1,33 +1,27 @@
 #pragma once
 
 #include <vector>
-#include <random>
 
-#include <maya/MPoint.h>
+#include <maya/MFnNurbsCurve.h>
+#include <maya/MFnParticleSystem.h>
+#include <maya/MVectorArray.h>
+#include <maya/MMatrix.h>
 
+#include "core/point-distribution.h"
+
+// Distributions that sample Maya objects, the rest are in the core library
 namespace PointDistribution
 {
-    std::vector<MPoint> uniformBoundingBox(const MPoint& min, const MPoint& max, size_t num);
-
-    std::vector<MPoint> sphereQuadratic(const MPoint& position, const std::array<MVector, 3>& axes, size_t num);
-
-    std::vector<MPoint> diskQuadratic(const MPoint& position, const std::array<MVector, 3>& axes, size_t axis, size_t num);
-
-    std::vector<MPoint> sphereSteps(const MPoint& position, const std::array<MVector, 3>& axes, size_t steps, double noise_sigma, size_t num);
-
-    std::vector<MPoint> diskSteps(const MPoint& position, const std::array<MVector, 3>& axes, size_t steps, size_t axis, double noise_sigma, size_t num);
-
-    std::vector<MPoint> curve(const MFnNurbsCurve &curve, double radius, size_t num);
-
-    std::vector<MPoint> particles(const MFnParticleSystem& particles);
+    // Samples the curve into an arc length table for PointDistribution::curves. Curve data
+    // from a worldSpace plug has no DAG path and must be sampled in object space.
+    CurveTable sampleCurve(const MFnNurbsCurve& curve, size_t samples_per_span = 32, MSpace::Space space = MSpace::kWorld);
 
-    std::vector<MPoint> removeDuplicates(const std::vector<MPoint>& points, double tolerance);
+    // Sphere distribution for an implicit sphere with world matrix M, flattened to a disk
+    // along x, y or z for disk_axis 1 to 3, and in rings if steps is not 0. Shared by the
+    // command and the preview node so that both place the same seeds.
+    std::vector<Geometry::Vec3> implicitSphere(const MMatrix& M, double radius, unsigned disk_axis, unsigned steps, double step_noise, size_t num, uint64_t seed, ThreadPool* pool = nullptr);
 
-    // Random engine
-    inline std::mt19937_64 engine = std::mt19937_64(std::random_device{}());
+    std::vector<Geometry::Vec3> particles(const MFnParticleSystem& particles);
 
-    // Common distributions
-    inline const std::uniform_real_distribution<double> theta_dist(0.0, M_PI);
-    inline const std::uniform_real_distribution<double> phi_dist(0.0, 2.0 * M_PI);
-    inline const std::uniform_real_distribution<double> unit_dist(0.0, 1.0);
+    std::vector<Geometry::Vec3> particles(const MVectorArray& positions);
 }
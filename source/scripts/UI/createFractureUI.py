@@ -10,7 +10,7 @@ CURVE_RADIUS_DEFAULT = 0.1
 DISK_AXIS_DEFAULT = ""
 STEPS_DEFAULT = 0
 STEP_NOISE_DEFAULT = 0.05
-MIN_DISTANCE_DEFAULT = 0.01
+MIN_DISTANCE_DEFAULT = 0.0
 
 def Diff(li1, li2):
     li_dif = [i for i in li1 + li2 if i not in li1 or i not in li2]
@@ -67,6 +67,37 @@ def UseCurve(*args):
 def UseParticleSystem(*args):
     mc.NCreateEmitter()
 
+# Creates a fracturePreview node for the selected mesh, using the selected implicit sphere,
+# curves or particles for seeds in the same order of preference as voronoiFracture
+def CreatePreview():
+    meshes = mc.ls(sl=True, dag=True, type='mesh', noIntermediate=True)
+    if(len(meshes) == 0):
+        mc.warning('Select a mesh to preview')
+        return None
+
+    preview = mc.createNode('fracturePreview')
+    mc.connectAttr(meshes[0] + '.outMesh', preview + '.inMesh')
+    mc.connectAttr(meshes[0] + '.worldMatrix[0]', preview + '.inMeshMatrix')
+
+    spheres = mc.ls(sl=True, dag=True, type='implicitSphere')
+    curves = mc.ls(sl=True, dag=True, type='nurbsCurve')
+    particles = mc.ls(sl=True, dag=True, type='nParticle')
+    if(len(spheres) > 0):
+        mc.setAttr(preview + '.seedSource', 1)
+        mc.connectAttr(spheres[0] + '.worldMatrix[0]', preview + '.sphereMatrix')
+        mc.connectAttr(spheres[0] + '.radius', preview + '.sphereRadius')
+    elif(len(curves) > 0):
+        mc.setAttr(preview + '.seedSource', 2)
+        for i, curve in enumerate(curves):
+            mc.connectAttr(curve + '.worldSpace[0]', preview + '.inCurves[%d]' % i)
+    elif(len(particles) > 0):
+        mc.setAttr(preview + '.seedSource', 3)
+        mc.connectAttr(particles[0] + '.position', preview + '.inPositions')
+
+    # Keep the selection for the fracture command
+    mc.select(meshes + spheres + curves + particles)
+    return preview
+
 class CreateFractureUI:
     def __init__(self, title, x, y):
         self.SIZE_X = x
@@ -78,14 +109,42 @@ class CreateFractureUI:
         self.STEPS = STEPS_DEFAULT
         self.STEP_NOISE = STEP_NOISE_DEFAULT
         self.MIN_DISTANCE = MIN_DISTANCE_DEFAULT
+        self.PREVIEW = None
         self._removeOld()
         self._build()
 
+    # Preview node attribute of every property
+    PREVIEW_ATTRIBUTES = { 'NUM_FRAGMENTS': 'numFragments', 'CURVE_RADIUS': 'curveRadius', 'STEPS': 'steps', 'STEP_NOISE': 'stepNoise', 'MIN_DISTANCE': 'minDistance' }
+
     def _applySlider(self, prop, val, *args):
         setattr(self, prop, val)
+        self._updatePreview()
+
+    def _hasPreview(self):
+        return self.PREVIEW is not None and mc.objExists(self.PREVIEW)
+
+    def _updatePreview(self):
+        if not self._hasPreview():
+            return
+        for prop, attribute in self.PREVIEW_ATTRIBUTES.items():
+            mc.setAttr(self.PREVIEW + '.' + attribute, getattr(self, prop))
+        mc.setAttr(self.PREVIEW + '.diskAxis', ["", "x", "y", "z"].index(self.DISK_AXIS))
+
+    def _preview(self, *args):
+        if self._hasPreview():
+            mc.delete(mc.listRelatives(self.PREVIEW, parent=True))
+        self.PREVIEW = CreatePreview()
+        self._updatePreview()
 
     def _fracture(self,*args):
-        mc.voronoiFracture(nf = self.NUM_FRAGMENTS, s = self.STEPS, sn = self.STEP_NOISE, da = self.DISK_AXIS, cr=self.CURVE_RADIUS, md=self.MIN_DISTANCE)
+        # The previewed cells are fractured with the seed of the preview, which is then removed
+        if self._hasPreview():
+            seed = mc.getAttr(self.PREVIEW + '.seed')
+            mc.delete(mc.listRelatives(self.PREVIEW, parent=True))
+            self.PREVIEW = None
+            mc.voronoiFracture(nf = self.NUM_FRAGMENTS, s = self.STEPS, sn = self.STEP_NOISE, da = self.DISK_AXIS, cr=self.CURVE_RADIUS, md=self.MIN_DISTANCE, sd=seed)
+        else:
+            mc.voronoiFracture(nf = self.NUM_FRAGMENTS, s = self.STEPS, sn = self.STEP_NOISE, da = self.DISK_AXIS, cr=self.CURVE_RADIUS, md=self.MIN_DISTANCE)
 
     def _radioButtonUpdate(self, prop, button, val, *args):
         activeButton = 1
@@ -99,6 +158,7 @@ class CreateFractureUI:
             setattr(self, prop, "y")
         elif(activeButton == 4):
             setattr(self, prop, "z")
+        self._updatePreview()
         
     def _removeOld(self):
         if mc.window("UI", exists=True):
@@ -172,7 +232,7 @@ class CreateFractureUI:
         mc.floatSliderGrp(sliderProp4, e=True, changeCommand = partial(self._applySlider, 'STEP_NOISE'))
 
         # A slider designed to alter step noise 
-        sliderProp2 = mc.floatSliderGrp(label=" Min Distance", min=0.01, max=10, value = self.MIN_DISTANCE, step=0.01, field=True, columnAlign=(1,'left'), cw=[(1, self.SIZE_X*0.3), (2, self.SIZE_X*0.2), (3, self.SIZE_X*0.45)])
+        sliderProp2 = mc.floatSliderGrp(label=" Min Distance", min=0.0, max=10, value = self.MIN_DISTANCE, step=0.01, field=True, columnAlign=(1,'left'), cw=[(1, self.SIZE_X*0.3), (2, self.SIZE_X*0.2), (3, self.SIZE_X*0.45)])
         mc.floatSliderGrp(sliderProp2, e=True, changeCommand = partial(self._applySlider, 'MIN_DISTANCE'))
 
         # Radio buttons for disk axis
@@ -181,10 +241,11 @@ class CreateFractureUI:
 
         # Apply button
         mc.separator( style='in', width=self.SIZE_X, height=20)
-        tmpRowWidth = [self.SIZE_X*0.5, self.SIZE_X*0.5]
-        mc.rowLayout(numberOfColumns=2, columnWidth2=tmpRowWidth)
-        mc.button('Fracture Mesh', l ='Fracture Mesh', width=tmpRowWidth[0], command = self._fracture, backgroundColor=[0.1, 0.3, 0.1], height=40)
-        mc.button('Clear Scene', width=tmpRowWidth[1], command = Delete, backgroundColor=[0.3, 0.1, 0.1], height=40)
+        tmpRowWidth = [self.SIZE_X*0.33, self.SIZE_X*0.33, self.SIZE_X*0.33]
+        mc.rowLayout(numberOfColumns=3, columnWidth3=tmpRowWidth)
+        mc.button('Preview', width=tmpRowWidth[0], command = self._preview, height=40)
+        mc.button('Fracture Mesh', l ='Fracture Mesh', width=tmpRowWidth[1], command = self._fracture, backgroundColor=[0.1, 0.3, 0.1], height=40)
+        mc.button('Clear Scene', width=tmpRowWidth[2], command = Delete, backgroundColor=[0.3, 0.1, 0.1], height=40)
         mc.setParent("..")
         mc.setParent("..")
         
@@ -0,0 +1,421 @@
+#include "test.h"
+
+#include <string>
+#include <iostream>
+#include <map>
+#include <algorithm>
+#include <sstream>
+#include <random>
+#include <filesystem>
+
+#include "core/fracture.h"
+#include "core/contacts.h"
+#include "core/mesh-io.h"
+#include "core/voronoi-cell.h"
+#include "core/vertex-buffer.h"
+#include "core/point-distribution.h"
+#include "core/thread-pool.h"
+
+using Geometry::Vec3;
+using Geometry::Mesh;
+
+namespace
+{
+    ThreadPool& pool()
+    {
+        static ThreadPool threads(2);
+        return threads;
+    }
+
+    // Seeds in the bounds of mesh, with some of them duplicated so that coincident seeds
+    // leave one empty cell
+    std::vector<Vec3> seedsFor(const Mesh& mesh, size_t num, Vec3& min, Vec3& max)
+    {
+        Geometry::Bounds bounds;
+        bounds.compute(mesh.vertices);
+        min = bounds.min;
+        max = bounds.max;
+
+        std::vector<Vec3> seeds = PointDistribution::uniformBoundingBox(min, max, num, 1);
+        for (size_t i = 0; i < num / 10; i++) seeds.push_back(seeds[i * 7]);
+        return seeds;
+    }
+
+    // Fragments of a closed mesh must be closed and fill the mesh without overlap
+    void checkFragments(const std::string& name, const Mesh& mesh, size_t num)
+    {
+        Vec3 min, max;
+        const std::vector<Vec3> seeds = seedsFor(mesh, num, min, max);
+
+        const std::vector<Geometry::VoronoiCell> cells = Fracture::buildCells(seeds, min, max, pool());
+        double cells_volume = 0.0;
+        size_t open_cells = 0;
+        for (const auto& cell : cells)
+        {
+            if (!Geometry::isClosed(cell.mesh)) open_cells++;
+            cells_volume += Test::volume(cell.mesh);
+        }
+        const Vec3 size = max - min;
+        CHECK(open_cells == 0);
+        CHECK(std::abs(cells_volume - size.x * size.y * size.z) < 1e-9 * size.x * size.y * size.z);
+
+        const std::vector<Mesh> fragments = Fracture::fractureMesh(mesh, seeds, min, max, pool());
+        double fragments_volume = 0.0;
+        size_t open_fragments = 0, empty_fragments = 0;
+        for (const Mesh& fragment : fragments)
+        {
+            if (fragment.empty()) empty_fragments++;
+            else if (!Geometry::isClosed(fragment)) open_fragments++;
+            fragments_volume += Test::volume(fragment);
+        }
+        CHECK(open_fragments == 0);
+        CHECK(empty_fragments >= num / 10);
+        CHECK(std::abs(fragments_volume - Test::volume(mesh)) < 1e-9 * Test::volume(mesh));
+
+        if (open_cells || open_fragments) std::cerr << name << ": " << open_cells << " open cells, " << open_fragments << " open fragments\n";
+    }
+
+    bool sameMesh(const Mesh& a, const Mesh& b, bool compare_tags = true)
+    {
+        return a.polygon_counts == b.polygon_counts && a.polygon_connects == b.polygon_connects
+            && (!compare_tags || a.polygon_tags == b.polygon_tags)
+            && std::equal(a.vertices.begin(), a.vertices.end(), b.vertices.begin(), b.vertices.end(),
+                [](const Vec3& p, const Vec3& q) { return p.x == q.x && p.y == q.y && p.z == q.z; });
+    }
+
+    // Area of every polygon of fragment summed by tag
+    std::map<int, double> areasByTag(const Mesh& fragment)
+    {
+        std::map<int, double> areas;
+        size_t offset = 0;
+        for (size_t f = 0; f < fragment.polygon_counts.size(); f++)
+        {
+            const int count = fragment.polygon_counts[f];
+            const Vec3& a = fragment.vertices[fragment.polygon_connects[offset]];
+            Vec3 sum;
+            for (int j = 1; j + 1 < count; j++)
+            {
+                sum += (fragment.vertices[fragment.polygon_connects[offset + j]] - a) ^ (fragment.vertices[fragment.polygon_connects[offset + j + 1]] - a);
+            }
+            areas[fragment.polygon_tags[f]] += 0.5 * sum.length();
+            offset += count;
+        }
+        return areas;
+    }
+
+    // Every fragment's faces are either on the surface of the source, tagged -1, or touch
+    // another fragment, so its contacts and surface add up to its total area
+    bool contactsCoverFaces(const std::vector<Mesh>& fragments, const std::vector<Fracture::Contact>& contacts)
+    {
+        std::vector<double> areas(fragments.size(), 0.0);
+        for (const auto& contact : contacts)
+        {
+            if (contact.a >= contact.b || contact.b >= fragments.size()) return false;
+            areas[contact.a] += contact.area;
+            areas[contact.b] += contact.area;
+        }
+
+        for (size_t i = 0; i < fragments.size(); i++)
+        {
+            double total = 0.0;
+            const std::map<int, double> by_tag = areasByTag(fragments[i]);
+            for (const auto& [tag, area] : by_tag) total += area;
+
+            const double outer = by_tag.count(-1) ? by_tag.at(-1) : 0.0;
+            if (std::abs(areas[i] + outer - total) > 1e-9 * std::max(total, 1.0)) return false;
+        }
+        return true;
+    }
+}
+
+TEST(fractureClosedMeshes)
+{
+    const Mesh cube = Geometry::boxMesh(Vec3(-1, -1, -1), Vec3(1, 1, 1));
+    const Mesh sphere = Geometry::sphereMesh(32, 64, 1.0);
+    const Mesh torus = Geometry::torusMesh(64, 32, 1.0, 0.4);
+
+    for (const Mesh* mesh : { &cube, &sphere, &torus }) CHECK(Geometry::isClosed(*mesh));
+
+    checkFragments("cube", cube, 200);
+    checkFragments("sphere", sphere, 200);
+    checkFragments("torus", torus, 200);
+}
+
+TEST(contactsOfCube)
+{
+    const Mesh cube = Geometry::boxMesh(Vec3(-1, -1, -1), Vec3(1, 1, 1));
+    Vec3 min, max;
+    const std::vector<Vec3> seeds = seedsFor(cube, 100, min, max);
+    const std::vector<Mesh> fragments = Fracture::fractureMesh(cube, seeds, min, max, pool());
+
+    // Both sides of a contact see the same area in their caps
+    const std::vector<Fracture::Contact> contacts = Fracture::contacts(fragments);
+    CHECK(!contacts.empty());
+    bool symmetric = true;
+    for (const auto& contact : contacts)
+    {
+        const std::map<int, double> a = areasByTag(fragments[contact.a]), b = areasByTag(fragments[contact.b]);
+        const auto ab = a.find((int)contact.b), ba = b.find((int)contact.a);
+        symmetric = symmetric && ab != a.end() && ba != b.end()
+            && std::abs(ab->second - contact.area) < 1e-12 && std::abs(ba->second - contact.area) < 1e-9 * contact.area;
+    }
+    CHECK(symmetric);
+    CHECK(contactsCoverFaces(fragments, contacts));
+
+    // Streamed in reverse order, the contacts are the same once sorted
+    std::vector<Fracture::Contact> streamed;
+    for (size_t i = fragments.size(); i-- > 0; ) Fracture::addContacts(fragments[i], i, streamed);
+    Fracture::sortContacts(streamed);
+    bool same_order = streamed.size() == contacts.size();
+    for (size_t i = 0; same_order && i < contacts.size(); i++)
+    {
+        same_order = streamed[i].a == contacts[i].a && streamed[i].b == contacts[i].b && streamed[i].area == contacts[i].area;
+    }
+    CHECK(same_order);
+
+    // Numbered like the non-empty fragments, contacts are those of the fragments without the
+    // empty cells of the duplicate seeds, with their caps retagged
+    std::vector<size_t> numbers(fragments.size());
+    std::vector<Mesh> kept;
+    for (size_t i = 0; i < fragments.size(); i++)
+    {
+        numbers[i] = kept.size();
+        if (!fragments[i].empty()) kept.push_back(fragments[i]);
+    }
+    CHECK(kept.size() < fragments.size());
+    for (Mesh& fragment : kept)
+    {
+        for (int& tag : fragment.polygon_tags)
+        {
+            if (tag >= 0) tag = (int)numbers[tag];
+        }
+    }
+
+    std::vector<Fracture::Contact> renumbered = contacts;
+    Fracture::renumberContacts(renumbered, numbers);
+    const std::vector<Fracture::Contact> expected = Fracture::contacts(kept);
+    bool same_contacts = renumbered.size() == expected.size();
+    for (size_t i = 0; same_contacts && i < expected.size(); i++)
+    {
+        same_contacts = renumbered[i].a == expected[i].a && renumbered[i].b == expected[i].b && std::abs(renumbered[i].area - expected[i].area) < 1e-9 * expected[i].area;
+    }
+    CHECK(same_contacts);
+    CHECK(contactsCoverFaces(kept, renumbered));
+}
+
+TEST(contactsOfSubFracture)
+{
+    // Fine fragments of different parents touch through the parent faces, which
+    // addParentContacts splits between the fine cells on their other side
+    const Mesh cube = Geometry::boxMesh(Vec3(-1, -1, -1), Vec3(1, 1, 1));
+    Vec3 min, max;
+    const std::vector<Vec3> seeds = seedsFor(cube, 20, min, max);
+    const Fracture::Level fine = Fracture::subFracture(Fracture::fractureLevel(cube, seeds, min, max, pool()), 8, 3, 0.0, pool());
+
+    std::vector<Mesh> fragments;
+    for (const auto& fragment : fine.fragments) fragments.push_back(*fragment);
+    for (Mesh& fragment : fragments)
+    {
+        for (int& tag : fragment.polygon_tags)
+        {
+            if (tag < -1) tag = -2;
+        }
+    }
+
+    const std::vector<Fracture::Contact> contacts = Fracture::contacts(fine);
+    CHECK(contactsCoverFaces(fragments, contacts));
+
+    bool across_parents = false;
+    for (const auto& contact : contacts) across_parents = across_parents || fine.parents[contact.a] != fine.parents[contact.b];
+    CHECK(across_parents);
+}
+
+TEST(subFractureTilesParents)
+{
+    // Fine fragments of each coarse fragment are closed and fill it without overlap
+    const Mesh sphere = Geometry::sphereMesh(24, 48, 1.0);
+    Vec3 min, max;
+    const std::vector<Vec3> seeds = seedsFor(sphere, 30, min, max);
+
+    Profiling::Profiler profiler;
+    const Fracture::Level coarse = Fracture::fractureLevel(sphere, seeds, min, max, pool(), nullptr, &profiler);
+    const Fracture::Level fine = Fracture::subFracture(coarse, 10, 5, 0.0, pool(), nullptr, &profiler);
+
+    CHECK(fine.parents.size() == fine.fragments.size());
+    CHECK(std::is_sorted(fine.parents.begin(), fine.parents.end()));
+
+    std::vector<double> volumes(coarse.fragments.size(), 0.0);
+    size_t open_fragments = 0;
+    for (size_t k = 0; k < fine.fragments.size(); k++)
+    {
+        if (!fine.fragments[k]->empty() && !Geometry::isClosed(*fine.fragments[k])) open_fragments++;
+        volumes[fine.parents[k]] += Test::volume(*fine.fragments[k]);
+    }
+    CHECK(open_fragments == 0);
+
+    bool tiled = true;
+    for (size_t i = 0; i < coarse.fragments.size(); i++)
+    {
+        const double volume = Test::volume(*coarse.fragments[i]);
+        tiled = tiled && std::abs(volumes[i] - volume) <= 1e-9 * std::max(volume, 1e-3);
+    }
+    CHECK(tiled);
+
+    // Both levels keep their profiles, numbered by the seeds of their own level
+    CHECK(profiler.fragments.size() == coarse.fragments.size() + fine.fragments.size());
+    bool numbered = true;
+    for (size_t i = 0; i < profiler.fragments.size(); i++)
+    {
+        const size_t expected = i < coarse.fragments.size() ? i : i - coarse.fragments.size();
+        numbered = numbered && profiler.fragments[i].seed == expected;
+    }
+    CHECK(numbered);
+}
+
+TEST(fractureInBatches)
+{
+    // Streamed fragments are the fragments of fractureMesh for any batch size, also after a
+    // round trip through the PLY files of the fragment cache, which don't keep tags
+    const Mesh torus = Geometry::torusMesh(32, 16, 1.0, 0.4);
+    Vec3 min, max;
+    const std::vector<Vec3> seeds = seedsFor(torus, 60, min, max);
+    const std::vector<Mesh> expected = Fracture::fractureMesh(torus, seeds, min, max, pool());
+    const size_t num_fragments = std::count_if(expected.begin(), expected.end(), [](const Mesh& m) { return !m.empty(); });
+
+    const std::filesystem::path cache = std::filesystem::temp_directory_path() / "voronoi-fracture-test-batches";
+    std::filesystem::create_directories(cache);
+
+    for (size_t batch_size : { (size_t)1, (size_t)17, seeds.size(), seeds.size() + 5 })
+    {
+        std::vector<Mesh> streamed(seeds.size());
+        size_t calls = 0, repeated = 0;
+        bool cached = true;
+
+        const bool completed = Fracture::fractureBatches(torus, seeds, min, max, pool(), batch_size,
+            [&](size_t i, Mesh& fragment)
+            {
+                calls++;
+                if (!streamed[i].empty()) repeated++;
+
+                const std::string file = (cache / ("fragment_" + std::to_string(i) + ".ply")).string();
+                Mesh read;
+                cached = cached && MeshIO::write(file, fragment) && MeshIO::read(file, read) && sameMesh(read, fragment, false);
+
+                streamed[i] = std::move(fragment);
+                return true;
+            });
+
+        CHECK(completed);
+        CHECK(cached);
+        CHECK(repeated == 0);
+        CHECK(calls == num_fragments);
+
+        bool same = true;
+        for (size_t i = 0; i < seeds.size(); i++) same = same && sameMesh(streamed[i], expected[i]);
+        CHECK(same);
+    }
+
+    std::filesystem::remove_all(cache);
+
+    // A sink that fails stops the fracture after its batch
+    size_t calls = 0;
+    CHECK(!Fracture::fractureBatches(torus, seeds, min, max, pool(), 17, [&](size_t, Mesh&) { return ++calls < 5; }));
+    CHECK(calls == 5);
+}
+
+namespace
+{
+    // Same polygons and tags with vertices equal up to rounding, cells may be clipped by their
+    // neighbours in another order when seeds were renumbered
+    bool closeMesh(const Mesh& a, const Mesh& b)
+    {
+        return a.polygon_counts == b.polygon_counts && a.polygon_connects == b.polygon_connects && a.polygon_tags == b.polygon_tags
+            && std::equal(a.vertices.begin(), a.vertices.end(), b.vertices.begin(), b.vertices.end(),
+                [](const Vec3& p, const Vec3& q) { return (p - q).length() < 1e-12; });
+    }
+
+    std::vector<int> sorted(std::vector<int> values)
+    {
+        std::sort(values.begin(), values.end());
+        return values;
+    }
+
+    // Refractured levels have the fragments and neighbours of a level computed from scratch
+    bool sameLevel(const Fracture::Level& level, const Fracture::Level& fresh)
+    {
+        if (level.seeds.size() != fresh.seeds.size() || level.fragments.size() != fresh.fragments.size() || level.cells.size() != fresh.cells.size()) return false;
+
+        for (size_t i = 0; i < fresh.fragments.size(); i++)
+        {
+            if (!closeMesh(*level.fragments[i], *fresh.fragments[i])) return false;
+            if (sorted(level.cells[i]->neighbours) != sorted(fresh.cells[i]->neighbours)) return false;
+        }
+        return true;
+    }
+}
+
+TEST(refractureMatchesFracture)
+{
+    const Mesh sphere = Geometry::sphereMesh(16, 32, 1.0);
+    Vec3 min, max;
+    std::vector<Vec3> seeds = seedsFor(sphere, 60, min, max);
+    seeds.resize(60);
+
+    Fracture::Level level = Fracture::fractureLevel(sphere, seeds, min, max, pool());
+    const std::vector<Vec3> extra = PointDistribution::uniformBoundingBox(min, max, 10, 2);
+
+    // Every change is applied to the seeds of the previous one
+    struct Change
+    {
+        const char* name;
+        std::function<void(std::vector<Vec3>&)> apply;
+    };
+    const Change changes[] =
+    {
+        { "add", [&](std::vector<Vec3>& s) { s.insert(s.end(), extra.begin(), extra.begin() + 5); } },
+        { "move", [&](std::vector<Vec3>& s) { s[3] = extra[5]; s[20] = extra[6]; s[41] = (s[41] + s[42]) * 0.5; } },
+        { "remove", [&](std::vector<Vec3>& s) { s.erase(s.begin() + 10, s.begin() + 12); s.erase(s.begin() + 40); } },
+        { "duplicate", [&](std::vector<Vec3>& s) { s.push_back(s[7]); s.insert(s.begin(), s[30]); } },
+        { "reorder", [&](std::vector<Vec3>& s) { std::shuffle(s.begin(), s.end(), std::mt19937(3)); } },
+        { "all", [&](std::vector<Vec3>& s) { s.erase(s.begin() + 5); s[8] = extra[7]; s.push_back(extra[8]); s.push_back(s[2]); std::reverse(s.begin(), s.end()); } },
+    };
+
+    for (const Change& change : changes)
+    {
+        change.apply(seeds);
+
+        // A copy of the level keeps its fragments and cells while the level is refractured
+        const Fracture::Level before = level;
+        std::vector<Mesh> before_fragments;
+        for (const auto& fragment : before.fragments) before_fragments.push_back(*fragment);
+
+        const size_t rebuilt = Fracture::refracture(level, sphere, seeds, min, max, pool());
+        const bool same = sameLevel(level, Fracture::fractureLevel(sphere, seeds, min, max, pool()));
+        CHECK(same);
+        CHECK(rebuilt <= seeds.size());
+
+        bool kept = true;
+        for (size_t i = 0; i < before.fragments.size(); i++) kept = kept && sameMesh(*before.fragments[i], before_fragments[i]);
+        CHECK(kept);
+
+        if (!same) std::cerr << "refracture after " << change.name << " differs from fracture\n";
+    }
+
+    // Moving a seed rebuilds its old and new neighbourhood, fragments of the other seeds keep
+    // their index and stay shared with the previous level. Seeds that repeat an earlier one
+    // count as added, so they are removed first.
+    seeds = PointDistribution::removeDuplicates(seeds, 1e-9);
+    Fracture::refracture(level, sphere, seeds, min, max, pool());
+    const Fracture::Level before = level;
+    seeds[0] = extra[9];
+    const size_t rebuilt = Fracture::refracture(level, sphere, seeds, min, max, pool());
+    size_t shared = 0;
+    for (size_t i = 0; i < seeds.size(); i++) shared += level.fragments[i] == before.fragments[i];
+    CHECK(rebuilt > 0 && rebuilt < seeds.size());
+    CHECK(shared + rebuilt == seeds.size());
+
+    // Reordering rebuilds nothing
+    std::reverse(seeds.begin(), seeds.end());
+    CHECK(Fracture::refracture(level, sphere, seeds, min, max, pool()) == 0);
+    CHECK(sameLevel(level, Fracture::fractureLevel(sphere, seeds, min, max, pool())));
+}
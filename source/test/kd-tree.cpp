@@ -0,0 +1,117 @@
+#include "test.h"
+
+#include <random>
+#include <utility>
+
+#include "core/kd-tree.h"
+
+using Geometry::Vec3;
+
+namespace
+{
+    // Compares the neighbours of p in query order with all points sorted by distance. Points
+    // at equal distance may come in any order, so both lists are compared sorted by index
+    // within equal distances.
+    bool matchesBruteForce(const std::vector<Vec3>& points, const Vec3& p)
+    {
+        std::vector<std::pair<double, size_t>> expected;
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            const double dx = points[i].x - p.x, dy = points[i].y - p.y, dz = points[i].z - p.z;
+            expected.emplace_back(dx * dx + dy * dy + dz * dz, i);
+        }
+        std::sort(expected.begin(), expected.end());
+
+        KdTree<Vec3> tree(points);
+        KdTree<Vec3>::Query query;
+        query.reset(tree, p);
+
+        std::vector<std::pair<double, size_t>> found;
+        size_t index;
+        double distance2;
+        while (query.next(index, distance2))
+        {
+            if (!found.empty() && distance2 < found.back().first) return false;
+            found.emplace_back(distance2, index);
+        }
+        std::sort(found.begin(), found.end());
+
+        return found == expected;
+    }
+
+    std::vector<Vec3> randomPoints(size_t num, unsigned seed)
+    {
+        std::mt19937 engine(seed);
+        std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+        std::vector<Vec3> points(num);
+        for (Vec3& p : points) p = Vec3(distribution(engine), distribution(engine), distribution(engine));
+        return points;
+    }
+}
+
+TEST(kdTreeOrder)
+{
+    const std::vector<Vec3> points = randomPoints(2000, 1);
+    for (size_t i = 0; i < 20; i++) CHECK(matchesBruteForce(points, points[i * 100]));
+
+    // Query points outside of the tree bounds and between the points
+    for (const Vec3& p : randomPoints(20, 2)) CHECK(matchesBruteForce(points, p * 3.0));
+    for (const Vec3& p : randomPoints(20, 3)) CHECK(matchesBruteForce(points, p));
+}
+
+TEST(kdTreeEmptyAndSingle)
+{
+    const std::vector<Vec3> empty;
+    KdTree<Vec3> empty_tree(empty);
+    KdTree<Vec3>::Query query;
+    size_t index;
+    double distance2;
+
+    query.reset(empty_tree, Vec3(0, 0, 0));
+    CHECK(!query.next(index, distance2));
+
+    const std::vector<Vec3> single = { Vec3(1, 2, 3) };
+    KdTree<Vec3> single_tree(single);
+    query.reset(single_tree, Vec3(1, 2, 4));
+    CHECK(query.next(index, distance2));
+    CHECK(index == 0 && distance2 == 1.0);
+    CHECK(!query.next(index, distance2));
+
+    CHECK(matchesBruteForce(single, Vec3(1, 2, 3)));
+}
+
+TEST(kdTreeDuplicates)
+{
+    // Few distinct points repeated many times, more than fit in one leaf
+    std::vector<Vec3> points;
+    const std::vector<Vec3> distinct = randomPoints(5, 4);
+    for (size_t i = 0; i < 200; i++) points.push_back(distinct[i % distinct.size()]);
+
+    for (const Vec3& p : distinct) CHECK(matchesBruteForce(points, p));
+    CHECK(matchesBruteForce(points, Vec3(0, 0, 0)));
+
+    // All points at one position
+    const std::vector<Vec3> same(50, Vec3(0.5, 0.5, 0.5));
+    CHECK(matchesBruteForce(same, Vec3(0.5, 0.5, 0.5)));
+    CHECK(matchesBruteForce(same, Vec3(0, 0, 0)));
+}
+
+TEST(kdTreeReset)
+{
+    // A query stopped early starts over after reset
+    const std::vector<Vec3> points = randomPoints(500, 5);
+    KdTree<Vec3> tree(points);
+    KdTree<Vec3>::Query query;
+    size_t index, first;
+    double distance2;
+
+    query.reset(tree, points[7]);
+    CHECK(query.next(first, distance2));
+    CHECK(first == 7 && distance2 == 0.0);
+    for (int i = 0; i < 10; i++) query.next(index, distance2);
+
+    query.reset(tree, points[7]);
+    CHECK(query.next(index, distance2));
+    CHECK(index == first);
+}
@@ -0,0 +1,65 @@
+// Runs the tests of the fracture core, or only those whose name contains the first argument
+
+#include <iostream>
+#include <string>
+#include <cstdlib>
+#include <algorithm>
+
+#include "test.h"
+
+namespace
+{
+    size_t failed_checks = 0;
+}
+
+void Test::fail(const char* file, int line, const char* condition)
+{
+    failed_checks++;
+    std::cerr << file << ":" << line << ": CHECK(" << condition << ") failed\n";
+}
+
+double Test::volume(const Geometry::Mesh& mesh)
+{
+    // Sum of the signed tetrahedra between the origin and a fan of every polygon
+    double six_volume = 0.0;
+    size_t offset = 0;
+    for (int count : mesh.polygon_counts)
+    {
+        const Geometry::Vec3& a = mesh.vertices[mesh.polygon_connects[offset]];
+        for (int j = 1; j + 1 < count; j++)
+        {
+            const Geometry::Vec3& b = mesh.vertices[mesh.polygon_connects[offset + j]];
+            const Geometry::Vec3& c = mesh.vertices[mesh.polygon_connects[offset + j + 1]];
+            six_volume += a * (b ^ c);
+        }
+        offset += count;
+    }
+    return six_volume / 6.0;
+}
+
+size_t Test::countTagged(const Geometry::Mesh& mesh, int tag)
+{
+    return std::count(mesh.polygon_tags.begin(), mesh.polygon_tags.end(), tag);
+}
+
+int main(int argc, char** argv)
+{
+    const std::string filter = argc > 1 ? argv[1] : "";
+
+    size_t run = 0, failed = 0;
+    for (const Test::Case& test : Test::cases())
+    {
+        if (!filter.empty() && std::string(test.name).find(filter) == std::string::npos) continue;
+
+        const size_t before = failed_checks;
+        test.run();
+        run++;
+
+        const bool passed = failed_checks == before;
+        if (!passed) failed++;
+        std::cerr << (passed ? "passed " : "FAILED ") << test.name << "\n";
+    }
+
+    std::cerr << run - failed << " of " << run << " tests passed\n";
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,167 @@
+#include "test.h"
+
+#include "core/mesh-clip.h"
+
+using Geometry::Vec3;
+using Geometry::Mesh;
+using Geometry::Plane;
+
+namespace
+{
+    constexpr int CAP = 7;
+
+    // Prism over the L-shaped polygon (0,0) (2,0) (2,1) (1,1) (1,2) (0,2) with height 1. Its top
+    // and bottom faces aren't convex.
+    Mesh lPrism()
+    {
+        Mesh mesh;
+        const double outline[6][2] = { { 0, 0 }, { 2, 0 }, { 2, 1 }, { 1, 1 }, { 1, 2 }, { 0, 2 } };
+        for (int z = 0; z < 2; z++)
+        {
+            for (const auto& p : outline) mesh.vertices.emplace_back(p[0], p[1], z);
+        }
+
+        mesh.polygon_counts = { 6, 6 };
+        mesh.polygon_connects = { 5, 4, 3, 2, 1, 0, /**/ 6, 7, 8, 9, 10, 11 };
+        for (int i = 0; i < 6; i++)
+        {
+            const int j = (i + 1) % 6;
+            mesh.polygon_counts.push_back(4);
+            mesh.polygon_connects.insert(mesh.polygon_connects.end(), { i, j, j + 6, i + 6 });
+        }
+        mesh.polygon_tags.assign(mesh.polygon_counts.size(), -1);
+
+        return mesh;
+    }
+
+    // True if every polygon tagged with tag faces along the plane normal, out of the kept part
+    bool capsFaceOutwards(const Mesh& mesh, const Plane& plane, int tag)
+    {
+        size_t offset = 0;
+        for (size_t i = 0; i < mesh.polygon_counts.size(); i++)
+        {
+            const int count = mesh.polygon_counts[i];
+            if (mesh.polygon_tags[i] == tag)
+            {
+                Vec3 normal(0, 0, 0);
+                for (int j = 0; j < count; j++)
+                {
+                    normal = normal + (mesh.vertices[mesh.polygon_connects[offset + j]] ^ mesh.vertices[mesh.polygon_connects[offset + (j + 1) % count]]);
+                }
+                if (normal.normal() * plane.normal < 1.0 - 1e-9) return false;
+            }
+            offset += count;
+        }
+        return true;
+    }
+
+    // Clips copies of mesh on both sides of the plane and checks that both halves are closed,
+    // capped once per cut loop and add up to the volume of the mesh
+    void checkHalves(const Mesh& mesh, const Plane& plane, const Plane& flipped, size_t loops)
+    {
+        Geometry::MeshClipper clipper;
+        Mesh below = mesh, above = mesh;
+
+        CHECK(clipper.clipAndCap(below, plane, CAP));
+        CHECK(clipper.clipAndCap(above, flipped, CAP));
+
+        for (const Mesh* half : { &below, &above })
+        {
+            CHECK(!half->empty());
+            CHECK(Geometry::isClosed(*half));
+            CHECK(Test::countTagged(*half, CAP) == loops);
+            CHECK(half->polygon_tags.size() == half->polygon_counts.size());
+        }
+        CHECK(capsFaceOutwards(below, plane, CAP));
+        CHECK(capsFaceOutwards(above, flipped, CAP));
+
+        CHECK(std::abs(Test::volume(below) + Test::volume(above) - Test::volume(mesh)) < 1e-9 * Test::volume(mesh));
+    }
+}
+
+TEST(clipBox)
+{
+    const Mesh box = Geometry::boxMesh(Vec3(0, 0, 0), Vec3(1, 1, 1));
+    const Plane plane(Vec3(1, 0, 0), Vec3(0.3, 0, 0));
+
+    Geometry::MeshClipper clipper;
+    Mesh clipped = box;
+    CHECK(clipper.clipAndCap(clipped, plane, CAP));
+    CHECK(Geometry::isClosed(clipped));
+    CHECK(clipped.polygon_counts.size() == 6);
+    CHECK(Test::countTagged(clipped, CAP) == 1);
+    CHECK(capsFaceOutwards(clipped, plane, CAP));
+    CHECK(std::abs(Test::volume(clipped) - 0.3) < 1e-12);
+
+    checkHalves(box, Plane(Vec3(1, 2, 3), Vec3(0.4, 0.5, 0.6)), Plane(Vec3(-1, -2, -3), Vec3(0.4, 0.5, 0.6)), 1);
+}
+
+TEST(clipNonConvex)
+{
+    const Mesh prism = lPrism();
+    CHECK(Geometry::isClosed(prism));
+    CHECK(std::abs(Test::volume(prism) - 3.0) < 1e-12);
+
+    // Cuts only the upper arm
+    Geometry::MeshClipper clipper;
+    Mesh clipped = prism;
+    const Plane plane(Vec3(0, 1, 0), Vec3(0, 1.5, 0));
+    CHECK(clipper.clipAndCap(clipped, plane, CAP));
+    CHECK(Geometry::isClosed(clipped));
+    CHECK(capsFaceOutwards(clipped, plane, CAP));
+    CHECK(std::abs(Test::volume(clipped) - 2.5) < 1e-12);
+
+    // Crosses the non-convex faces through both arms, cutting off their ends in two loops
+    checkHalves(prism, Plane(Vec3(1, 1, 0.2), Vec3(1.2, 1.2, 0.5)), Plane(Vec3(-1, -1, -0.2), Vec3(1.2, 1.2, 0.5)), 2);
+
+    // Two separate cut loops through the tube, each with its own cap
+    const Mesh torus = Geometry::torusMesh(48, 24, 1.0, 0.4);
+    CHECK(Geometry::isClosed(torus));
+    checkHalves(torus, Plane(Vec3(1, 0, 0), Vec3(0.3, 0, 0)), Plane(Vec3(-1, 0, 0), Vec3(0.3, 0, 0)), 2);
+}
+
+TEST(clipThroughVertices)
+{
+    const Mesh box = Geometry::boxMesh(Vec3(0, 0, 0), Vec3(1, 1, 1));
+
+    // Along a face, vertices on the plane are kept
+    Geometry::MeshClipper clipper;
+    Mesh clipped = box;
+    CHECK(!clipper.clipAndCap(clipped, Plane(Vec3(1, 0, 0), Vec3(1, 0, 0)), CAP));
+    CHECK(clipped.polygon_connects == box.polygon_connects);
+
+    // Along the diagonal through four vertices of the box and of the non-convex prism
+    checkHalves(box, Plane(Vec3(1, -1, 0), Vec3(0, 0, 0)), Plane(Vec3(-1, 1, 0), Vec3(0, 0, 0)), 1);
+    checkHalves(lPrism(), Plane(Vec3(1, 0, 0), Vec3(1, 0, 0)), Plane(Vec3(-1, 0, 0), Vec3(1, 0, 0)), 1);
+
+    // Bisectors decide vertices on the plane from the seeds, so the two cells sharing the
+    // plane still split the box without overlap
+    const Vec3 a(0, 1, 0.5), b(1, 0, 0.5);
+    checkHalves(box, Geometry::getBisectorPlane(a, b, 0, 1), Geometry::getBisectorPlane(b, a, 1, 0), 1);
+
+    Mesh cell = box;
+    CHECK(clipper.clipAndCap(cell, Geometry::getBisectorPlane(a, b, 0, 1), CAP));
+    CHECK(std::abs(Test::volume(cell) - 0.5) < 1e-12);
+}
+
+TEST(clipInsideAndOutside)
+{
+    const Mesh box = Geometry::boxMesh(Vec3(0, 0, 0), Vec3(1, 1, 1));
+    Geometry::MeshClipper clipper;
+
+    Mesh inside = box;
+    CHECK(!clipper.clipAndCap(inside, Plane(Vec3(1, 1, 0), Vec3(2, 2, 0)), CAP));
+    CHECK(inside.polygon_connects == box.polygon_connects);
+    CHECK(inside.polygon_tags == box.polygon_tags);
+    CHECK(Test::countTagged(inside, CAP) == 0);
+
+    Mesh outside = box;
+    CHECK(clipper.clipAndCap(outside, Plane(Vec3(-1, -1, 0), Vec3(2, 2, 0)), CAP));
+    CHECK(outside.empty());
+
+    // The clipper is reused after clipping everything away
+    Mesh prism = lPrism();
+    CHECK(clipper.clipAndCap(prism, Plane(Vec3(0, 0, 1), Vec3(0, 0, 0.25)), CAP));
+    CHECK(Geometry::isClosed(prism));
+    CHECK(std::abs(Test::volume(prism) - 0.75) < 1e-12);
+}
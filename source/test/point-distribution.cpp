@@ -0,0 +1,247 @@
+#include "test.h"
+
+#include <tuple>
+#include <cmath>
+#include <limits>
+
+#include "core/point-distribution.h"
+#include "core/vertex-buffer.h"
+#include "core/thread-pool.h"
+
+using Geometry::Vec3;
+
+namespace
+{
+    std::vector<Vec3> removeDuplicatesReference(const std::vector<Vec3>& points, double tolerance)
+    {
+        std::vector<Vec3> kept;
+        for (const Vec3& p : points)
+        {
+            bool add = true;
+            for (const Vec3& q : kept) add = add && (p - q).length() >= tolerance;
+            if (add) kept.push_back(p);
+        }
+        return kept;
+    }
+
+    bool same(const std::vector<Vec3>& a, const std::vector<Vec3>& b)
+    {
+        return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(),
+            [](const Vec3& p, const Vec3& q) { return p.x == q.x && p.y == q.y && p.z == q.z; });
+    }
+
+    bool same(const Geometry::VertexBuffer& a, const Geometry::VertexBuffer& b)
+    {
+        return a.x == b.x && a.y == b.y && a.z == b.z;
+    }
+
+    // True if the batch points are within tolerance of the scalar ones
+    bool near(const std::vector<Vec3>& points, const Geometry::VertexBuffer& batch, double tolerance)
+    {
+        if (points.size() != batch.size()) return false;
+        for (size_t i = 0; i < points.size(); i++)
+        {
+            if ((points[i] - Vec3(batch.x[i], batch.y[i], batch.z[i])).length() > tolerance) return false;
+        }
+        return true;
+    }
+
+    // Runs a scalar and a batch sampler without a pool and with pools of one and four threads.
+    // Each must give the same points for every pool, and the batch points must agree with the
+    // scalar ones up to rounding.
+    template<class Scalar, class Batch>
+    void checkSampler(const Scalar& scalar, const Batch& batch, double tolerance)
+    {
+        ThreadPool one(1), four(4);
+
+        const std::vector<Vec3> points = scalar(nullptr);
+        CHECK(same(scalar(&one), points));
+        CHECK(same(scalar(&four), points));
+
+        Geometry::VertexBuffer serial, single, parallel;
+        batch(serial, nullptr);
+        batch(single, &one);
+        batch(parallel, &four);
+        CHECK(same(single, serial));
+        CHECK(same(parallel, serial));
+
+        CHECK(near(points, serial, tolerance));
+    }
+}
+
+TEST(removeDuplicates)
+{
+    const std::vector<Vec3> points = PointDistribution::uniformBoundingBox(Vec3(-1, -1, -1), Vec3(1, 1, 1), 3000, 1);
+    for (double tolerance : { 1e-3, 0.05, 0.2 })
+    {
+        CHECK(same(PointDistribution::removeDuplicates(points, tolerance), removeDuplicatesReference(points, tolerance)));
+    }
+
+    // Cell indices that don't fit in an int64 are clamped instead of overflowing
+    const std::vector<Vec3> far = { Vec3(1e300, -1e300, 0), Vec3(1e300, -1e300, 1e-300), Vec3(-1e300, 1e300, 5), Vec3(0, 0, 0) };
+    CHECK(same(PointDistribution::removeDuplicates(far, 1e-10), removeDuplicatesReference(far, 1e-10)));
+    CHECK(PointDistribution::removeDuplicates(far, 1e-10).size() == 3);
+}
+
+TEST(spatialOrderPermutation)
+{
+    // Random points with some duplicates, and points outside of the bounds
+    std::vector<Vec3> points = PointDistribution::uniformBoundingBox(Vec3(-1, -2, -3), Vec3(1, 2, 3), 5000, 2);
+    for (size_t i = 0; i < 500; i++) points.push_back(points[i * 3]);
+    points.push_back(Vec3(10, -10, 0));
+
+    auto less = [](const Vec3& a, const Vec3& b) { return std::tie(a.x, a.y, a.z) < std::tie(b.x, b.y, b.z); };
+    std::vector<Vec3> expected = points;
+    std::sort(expected.begin(), expected.end(), less);
+
+    for (auto curve : { PointDistribution::Curve::NONE, PointDistribution::Curve::MORTON, PointDistribution::Curve::HILBERT })
+    {
+        std::vector<size_t> order = PointDistribution::spatialOrder(points, Vec3(-1, -2, -3), Vec3(1, 2, 3), curve);
+        std::sort(order.begin(), order.end());
+        bool identity = order.size() == points.size();
+        for (size_t i = 0; identity && i < order.size(); i++) identity = order[i] == i;
+        CHECK(identity);
+
+        std::vector<Vec3> sorted = PointDistribution::sortSpatially(points, curve);
+        std::sort(sorted.begin(), sorted.end(), less);
+        CHECK(same(sorted, expected));
+    }
+}
+
+TEST(hilbertAdjacency)
+{
+    // One point in the middle of every block of a 2^k grid over the 2^21 cells per axis. The
+    // curve fills each block before the next, so consecutive points are in adjacent blocks.
+    const double max_cell = (1 << 21) - 1;
+    for (int k = 1; k <= 4; k++)
+    {
+        const int n = 1 << k;
+        const double step = (double)(1 << (21 - k));
+
+        std::vector<Vec3> points;
+        for (int x = 0; x < n; x++)
+            for (int y = 0; y < n; y++)
+                for (int z = 0; z < n; z++) points.emplace_back((x + 0.5) * step, (y + 0.5) * step, (z + 0.5) * step);
+
+        const std::vector<size_t> order = PointDistribution::spatialOrder(points, Vec3(0, 0, 0), Vec3(max_cell, max_cell, max_cell), PointDistribution::Curve::HILBERT);
+
+        size_t jumps = 0;
+        for (size_t i = 1; i < order.size(); i++)
+        {
+            const Vec3 d = points[order[i]] - points[order[i - 1]];
+            const double manhattan = std::abs(d.x) + std::abs(d.y) + std::abs(d.z);
+            if (manhattan != step) jumps++;
+        }
+        CHECK(jumps == 0);
+    }
+}
+
+TEST(batchSamplers)
+{
+    // Sizes over several chunks and not a multiple of the SIMD width
+    const size_t num = 10003;
+    const uint64_t seed = 7;
+    const Vec3 min(-1, -2, -3), max(4, 5, 6), position(1, 2, 3);
+    const std::array<Vec3, 3> axes = { Vec3(2, 0, 0), Vec3(0, 1, 1), Vec3(0, -0.5, 0.5) };
+    const double tolerance = 1e-12;
+
+    using namespace PointDistribution;
+    using Geometry::VertexBuffer;
+
+    checkSampler([&](ThreadPool* pool) { return uniformBoundingBox(min, max, num, seed, pool); },
+                 [&](VertexBuffer& points, ThreadPool* pool) { uniformBoundingBox(min, max, num, seed, points, pool); }, tolerance);
+    checkSampler([&](ThreadPool* pool) { return sphereQuadratic(position, axes, num, seed, pool); },
+                 [&](VertexBuffer& points, ThreadPool* pool) { sphereQuadratic(position, axes, num, seed, points, pool); }, tolerance);
+    checkSampler([&](ThreadPool* pool) { return diskQuadratic(position, axes, 1, num, seed, pool); },
+                 [&](VertexBuffer& points, ThreadPool* pool) { diskQuadratic(position, axes, 1, num, seed, points, pool); }, tolerance);
+    checkSampler([&](ThreadPool* pool) { return sphereSteps(position, axes, 5, 0.1, num, seed, pool); },
+                 [&](VertexBuffer& points, ThreadPool* pool) { sphereSteps(position, axes, 5, 0.1, num, seed, points, pool); }, tolerance);
+    checkSampler([&](ThreadPool* pool) { return diskSteps(position, axes, 5, 2, 0.1, num, seed, pool); },
+                 [&](VertexBuffer& points, ThreadPool* pool) { diskSteps(position, axes, 5, 2, 0.1, num, seed, points, pool); }, tolerance);
+}
+
+namespace
+{
+    // Distance from p to the polyline of a curve table
+    double distanceToPolyline(const PointDistribution::CurveTable& table, const Vec3& p)
+    {
+        double nearest = std::numeric_limits<double>::max();
+        for (size_t i = 0; i + 1 < table.positions.size(); i++)
+        {
+            const Vec3 a = table.positions[i], d = table.positions[i + 1] - a;
+            const double t = std::min(std::max((p - a) * d / (d * d), 0.0), 1.0);
+            nearest = std::min(nearest, (p - (a + d * t)).length());
+        }
+        return nearest;
+    }
+}
+
+TEST(curveTables)
+{
+    // Straight line sampled at uneven parameters, arc length maps linearly to position
+    PointDistribution::CurveTable line;
+    for (double x : { 0.0, 0.1, 0.5, 2.0, 3.0 }) line.add(Vec3(x, 1, 2), Vec3(1, 0, 0));
+    CHECK(line.length() == 3.0);
+
+    bool linear = true;
+    for (int i = 0; i <= 300; i++)
+    {
+        const double s = i * 0.01;
+        Vec3 position, tangent;
+        line.evaluate(s, position, tangent);
+        linear = linear && std::abs(position.x - s) < 1e-12 && position.y == 1 && position.z == 2 && tangent.x == 1.0;
+    }
+    CHECK(linear);
+
+    Vec3 position, tangent;
+    line.evaluate(-1.0, position, tangent);
+    CHECK(position.x == 0.0);
+    line.evaluate(4.0, position, tangent);
+    CHECK(position.x == 3.0);
+
+    // Closed circle of radius 2 around (1, 0, 0) in 64 segments, positions advance along each
+    // segment by the arc length and stay between the chords and the circle
+    const double radius = 2.0;
+    const int segments = 64;
+    PointDistribution::CurveTable circle;
+    for (int i = 0; i <= segments; i++)
+    {
+        const double angle = 2.0 * M_PI * i / segments;
+        circle.add(Vec3(1 + radius * std::cos(angle), radius * std::sin(angle), 0), Vec3(-std::sin(angle), std::cos(angle), 0));
+    }
+    const double chord = 2.0 * radius * std::sin(M_PI / segments);
+    CHECK(std::abs(circle.length() - segments * chord) < 1e-12);
+
+    bool on_circle = true;
+    for (int i = 0; i < 1000; i++)
+    {
+        const double s = circle.length() * i / 1000.0;
+        circle.evaluate(s, position, tangent);
+
+        const size_t j = std::min((size_t)(s / chord), (size_t)segments - 1);
+        const double along = (position - circle.positions[j]).length();
+        const double distance = (position - Vec3(1, 0, 0)).length();
+        on_circle = on_circle && std::abs(along - (s - circle.lengths[j])) < 1e-9
+            && distance <= radius + 1e-12 && distance >= radius * std::cos(M_PI / segments) - 1e-12
+            && std::abs(tangent.length() - 1.0) < 1e-12;
+    }
+    CHECK(on_circle);
+
+    // Tube samples stay within the tube radius of their curve, and the curves get points in
+    // proportion to their length
+    const double tube = 0.05;
+    const std::vector<Vec3> points = PointDistribution::curves({ line, circle }, tube, 20000, 9);
+    CHECK(points.size() == 20000);
+
+    size_t outside = 0, on_line = 0;
+    for (const Vec3& p : points)
+    {
+        const double to_line = distanceToPolyline(line, p), to_circle = distanceToPolyline(circle, p);
+        if (std::min(to_line, to_circle) > tube * (1.0 + 1e-9)) outside++;
+        if (to_line < to_circle) on_line++;
+    }
+    CHECK(outside == 0);
+
+    const double expected = points.size() * line.length() / (line.length() + circle.length());
+    CHECK(std::abs(on_line - expected) < 4.0 * std::sqrt(expected));
+}
@@ -0,0 +1,154 @@
+#include "test.h"
+
+#include <cmath>
+#include <random>
+#include <tuple>
+
+#include "core/predicates.h"
+
+using Geometry::Vec3;
+
+namespace
+{
+    // Coordinates are multiples of 2^-60 below 1 in magnitude, so they scale to integers below
+    // 2^60 and the bisector products fit in 128 bits
+    constexpr int SCALE = 60;
+
+    __int128 scaled(double v)
+    {
+        return (__int128)(int64_t)std::ldexp(v, SCALE);
+    }
+
+    bool representable(double v)
+    {
+        const double s = std::ldexp(v, SCALE);
+        return std::abs(v) < 1.0 && s == std::floor(s);
+    }
+
+    // Sign of |x - p0|^2 - |x - p1|^2 = (p1 - p0) . (2x - p0 - p1) in integer arithmetic
+    int bisectorReference(const Vec3& p0, const Vec3& p1, const Vec3& x)
+    {
+        const double a[3][3] = { { p0.x, p1.x, x.x }, { p0.y, p1.y, x.y }, { p0.z, p1.z, x.z } };
+        __int128 d = 0;
+        for (const auto& c : a)
+        {
+            d += (scaled(c[1]) - scaled(c[0])) * (2 * scaled(c[2]) - scaled(c[0]) - scaled(c[1]));
+        }
+        return (d > 0) - (d < 0);
+    }
+
+    // Checks the predicate and the side of the bisector plane against the reference. Points on
+    // the bisector go to the lexicographically smaller seed.
+    bool matchesReference(const Vec3& p0, const Vec3& p1, const Vec3& x)
+    {
+        for (const Vec3* p : { &p0, &p1, &x })
+        {
+            if (!representable(p->x) || !representable(p->y) || !representable(p->z)) return false;
+        }
+
+        const int expected = bisectorReference(p0, p1, x);
+        if (Predicates::bisector(p0, p1, x) != expected) return false;
+
+        const bool p0_first = std::tie(p0.x, p0.y, p0.z) < std::tie(p1.x, p1.y, p1.z);
+        const int side = expected != 0 ? expected : p0_first ? -1 : 1;
+        const Geometry::Plane plane = Geometry::getBisectorPlane(p0, p1, 0, 1);
+        return plane.side(x) == side && plane.exactSide(x) == side;
+    }
+
+    double randomCoordinate(std::mt19937_64& engine)
+    {
+        // Multiples of 2^-30, so sums of a few of them are still multiples of 2^-60
+        return std::ldexp((double)(int64_t)(engine() % (1ull << 30)) - (double)(1ull << 29), -30);
+    }
+
+    // Away from 0, so that the neighbouring doubles are still multiples of 2^-60
+    double randomOffset(std::mt19937_64& engine)
+    {
+        return 0.25 + 0.25 * randomCoordinate(engine);
+    }
+
+    Vec3 randomPoint(std::mt19937_64& engine)
+    {
+        const double x = randomCoordinate(engine), y = randomCoordinate(engine);
+        return Vec3(x, y, randomCoordinate(engine));
+    }
+}
+
+TEST(bisectorRandom)
+{
+    std::mt19937_64 engine(1);
+    for (int i = 0; i < 10000; i++)
+    {
+        CHECK(matchesReference(randomPoint(engine), randomPoint(engine), randomPoint(engine)));
+    }
+}
+
+TEST(bisectorOnPlane)
+{
+    // Seeds mirrored in the planes x = y, x = 0 and x + y = 0, with points exactly on them
+    std::mt19937_64 engine(2);
+    for (int i = 0; i < 1000; i++)
+    {
+        const Vec3 p = randomPoint(engine), q = randomPoint(engine);
+        const double s = randomCoordinate(engine);
+
+        const Vec3 swapped(p.y, p.x, p.z), mirrored(-p.x, p.y, p.z), flipped(-p.y, -p.x, p.z);
+        const Vec3 on_swapped(s, s, q.z), on_mirrored(0, q.y, q.z), on_flipped(s, -s, q.z);
+
+        CHECK(Predicates::bisector(p, swapped, on_swapped) == 0);
+        CHECK(Predicates::bisector(p, mirrored, on_mirrored) == 0);
+        CHECK(Predicates::bisector(p, flipped, on_flipped) == 0);
+
+        CHECK(matchesReference(p, swapped, on_swapped));
+        CHECK(matchesReference(swapped, p, on_swapped));
+        CHECK(matchesReference(p, mirrored, on_mirrored));
+        CHECK(matchesReference(p, flipped, on_flipped));
+    }
+}
+
+TEST(bisectorNearTies)
+{
+    // Points 1 ulp off the bisector, where the floating point result is within its error bound
+    // and the sign comes from the exact evaluation
+    std::mt19937_64 engine(3);
+    for (int i = 0; i < 1000; i++)
+    {
+        const Vec3 p = randomPoint(engine), q = randomPoint(engine);
+        const double s = randomOffset(engine);
+        const Vec3 swapped(p.y, p.x, p.z);
+
+        for (double direction : { -1.0, 1.0 })
+        {
+            const double t = std::nextafter(s, direction);
+            CHECK(matchesReference(p, swapped, Vec3(t, s, q.z)));
+            CHECK(matchesReference(p, swapped, Vec3(s, t, q.z)));
+            CHECK(matchesReference(swapped, p, Vec3(t, s, q.z)));
+
+            // Seeds 1 ulp apart, so their difference cancels almost completely
+            const Vec3 seed(s, p.y, p.z), close(t, p.y, p.z);
+            CHECK(matchesReference(seed, close, q));
+            CHECK(matchesReference(seed, close, Vec3(s, q.y, q.z)));
+            CHECK(matchesReference(seed, close, Vec3(t, q.y, q.z)));
+            CHECK(matchesReference(close, seed, Vec3(s, q.y, q.z)));
+        }
+    }
+}
+
+TEST(bisectorCoincidentSeeds)
+{
+    // Coincident seeds are equidistant to every point and the lower index takes it, from
+    // either side of the plane
+    std::mt19937_64 engine(4);
+    for (int i = 0; i < 100; i++)
+    {
+        const Vec3 p = randomPoint(engine), x = randomPoint(engine);
+        CHECK(Predicates::bisector(p, p, x) == 0);
+
+        const Geometry::Plane forward = Geometry::getBisectorPlane(p, p, 3, 5);
+        const Geometry::Plane backward = Geometry::getBisectorPlane(p, p, 5, 3);
+        CHECK(forward.exactSide(x) == -1);
+        CHECK(backward.exactSide(x) == 1);
+        CHECK(forward.side(x) == -1);
+        CHECK(backward.side(x) == 1);
+    }
+}
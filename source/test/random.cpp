@@ -0,0 +1,31 @@
+#include "test.h"
+
+#include "core/random.h"
+
+TEST(philoxKnownAnswers)
+{
+    // Philox4x32-10 vectors published with Random123 (kat_vectors), counter then key to output
+    struct Vector
+    {
+        std::array<uint32_t, 4> counter;
+        std::array<uint32_t, 2> key;
+        std::array<uint32_t, 4> output;
+    };
+
+    const Vector vectors[] =
+    {
+        { { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }, { 0x00000000, 0x00000000 }, { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 } },
+        { { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0xffffffff, 0xffffffff }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd } },
+        { { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 }, { 0xa4093822, 0x299f31d0 }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } },
+    };
+
+    for (const Vector& v : vectors) CHECK(Random::philox(v.counter, v.key) == v.output);
+
+    // Streams return the words of each block in pairs, with the sample index in the low
+    // counter words and the block and stream in the high ones
+    Random::Stream rng(0x299f31d0a4093822ull, 0x03707344);
+    rng.seek(0x85a308d3243f6a88ull);
+    const std::array<uint32_t, 4> block = Random::philox({ 0x243f6a88, 0x85a308d3, 0, 0x03707344 }, { 0xa4093822, 0x299f31d0 });
+    CHECK(rng() == (((uint64_t)block[0] << 32) | block[1]));
+    CHECK(rng() == (((uint64_t)block[2] << 32) | block[3]));
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+
+#include "core/geometry.h"
+
+// Minimal test registry for the Maya independent core. TEST defines a test function that is
+// registered before main runs, CHECK reports a failed condition and continues the test.
+
+namespace Test
+{
+    struct Case
+    {
+        const char* name;
+        void (*run)();
+    };
+
+    inline std::vector<Case>& cases()
+    {
+        static std::vector<Case> registered;
+        return registered;
+    }
+
+    struct Registration
+    {
+        Registration(const char* name, void (*run)()) { cases().push_back({ name, run }); }
+    };
+
+    // Records a failed CHECK of the running test
+    void fail(const char* file, int line, const char* condition);
+
+    // Enclosed volume of a closed, outward oriented mesh with planar polygons
+    double volume(const Geometry::Mesh& mesh);
+
+    // Number of polygons tagged with tag
+    size_t countTagged(const Geometry::Mesh& mesh, int tag);
+}
+
+#define TEST(name) \
+    static void name(); \
+    static const Test::Registration name##_registration(#name, name); \
+    static void name()
+
+#define CHECK(condition) \
+    do { if (!(condition)) Test::fail(__FILE__, __LINE__, #condition); } while (false)
@@ -3,41 +3,72 @@
 #include <random>
 #include <maya/MPoint.h>
 #include <maya/MFnMesh.h>
-#include <maya/MItMeshVertex.h>
 #include <maya/MDagPath.h>
+#include <maya/MPointArray.h>
+#include <maya/MIntArray.h>
 
-double Plane::signedDistance(const MVector& x) const
+Geometry::VertexBuffer getVertexBuffer(const MFnMesh& mesh)
 {
-    return normal * (x - point);
-}
+    MPointArray points;
+    mesh.getPoints(points, MSpace::kWorld);
 
-bool Plane::intersects(const MFnMesh& mesh, bool& strictly_greater) const
-{
-    bool greater = false, less = false;
-    strictly_greater = false;
-    for (MItMeshVertex it(mesh.dagPath()); !it.isDone(); it.next())
-    {
-        MStatus status;
-        if (signedDistance(it.position(MSpace::kWorld)) > 0.0)
-            greater = true;
-        else
-            less = true;
+    Geometry::VertexBuffer vertices;
+    vertices.x.resize(points.length());
+    vertices.y.resize(points.length());
+    vertices.z.resize(points.length());
 
-        if (greater && less) return true;
+    for (unsigned int i = 0; i < points.length(); i++)
+    {
+        vertices.x[i] = points[i].x;
+        vertices.y[i] = points[i].y;
+        vertices.z[i] = points[i].z;
     }
-    strictly_greater = greater && !less;
-    return false;
+    vertices.updateBounds();
+
+    return vertices;
 }
 
-Plane getBisectorPlane(const MPoint& p0, const MPoint& p1)
+Geometry::Mesh getMesh(const MFnMesh& mesh, MSpace::Space space)
 {
-    return Plane(p1 - p0, (p0 + p1) * 0.5);
+    Geometry::Mesh result;
+
+    MPointArray points;
+    mesh.getPoints(points, space);
+
+    result.vertices.resize(points.length());
+    for (unsigned int i = 0; i < points.length(); i++)
+    {
+        result.vertices[i] = toVec3(points[i]);
+    }
+
+    MIntArray counts, connects;
+    mesh.getVertices(counts, connects);
+
+    result.polygon_counts.resize(counts.length());
+    counts.get(result.polygon_counts.data());
+
+    result.polygon_connects.resize(connects.length());
+    connects.get(result.polygon_connects.data());
+
+    result.polygon_tags.assign(counts.length(), -1);
+
+    return result;
 }
 
-MVector orthogonalUnitVector(const MVector& v)
+MStatus setMesh(MFnMesh& mesh, const Geometry::Mesh& geometry, const MMatrix& M)
 {
-    if (std::abs(v.x) > std::abs(v.y))
-        return MVector(-v.z, 0, v.x) / std::sqrt(v.x * v.x + v.z * v.z);
-    else
-        return MVector(0, v.z, -v.y) / std::sqrt(v.y * v.y + v.z * v.z);
+    MPointArray points((unsigned)geometry.vertices.size());
+    for (unsigned int i = 0; i < points.length(); i++)
+    {
+        const auto& v = geometry.vertices[i];
+        points[i] = MPoint(v.x, v.y, v.z) * M;
+    }
+
+    return mesh.createInPlace(
+        points.length(),
+        (int)geometry.polygon_counts.size(),
+        points,
+        MIntArray(geometry.polygon_counts.data(), (unsigned)geometry.polygon_counts.size()),
+        MIntArray(geometry.polygon_connects.data(), (unsigned)geometry.polygon_connects.size())
+    );
 }
\ No newline at end of file
@@ -2,21 +2,24 @@
 
 #include <vector>
 #include <maya/MVector.h>
+#include <maya/MPoint.h>
+#include <maya/MMatrix.h>
 #include <maya/MGlobal.h>
 
-struct Plane
-{
-    Plane(const MVector& n, const MVector& p) : normal(n.normal()), point(p) { }
+#include "core/geometry.h"
+#include "core/vertex-buffer.h"
 
-    double signedDistance(const MVector& x) const;
-    bool intersects(const MFnMesh& mesh, bool& strictly_greater) const;
+// World space vertex positions of mesh
+Geometry::VertexBuffer getVertexBuffer(const MFnMesh& mesh);
 
-    MVector normal, point;
-};
+inline Geometry::Vec3 toVec3(const MPoint& p) { return Geometry::Vec3(p.x, p.y, p.z); }
+inline Geometry::Vec3 toVec3(const MVector& v) { return Geometry::Vec3(v.x, v.y, v.z); }
 
-Plane getBisectorPlane(const MPoint& p0, const MPoint& p1);
+// Reads mesh into flat vertex and index buffers
+Geometry::Mesh getMesh(const MFnMesh& mesh, MSpace::Space space);
 
-MVector orthogonalUnitVector(const MVector& v);
+// Replaces the geometry of mesh, transforming vertices by M first
+MStatus setMesh(MFnMesh& mesh, const Geometry::Mesh& geometry, const MMatrix& M);
 
 template<class T>
 void displayNumber(const T& number)
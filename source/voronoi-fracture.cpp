@@ -2,6 +2,7 @@
 
 #include <chrono>
 #include <array>
+#include <algorithm>
 
 #include <maya/MGlobal.h>
 #include <maya/MDagPath.h>
@@ -24,29 +25,92 @@
 #include <maya/MDagPathArray.h>
 #include <maya/MPlug.h>
 #include <maya/MFnParticleSystem.h>
+#include <maya/MFnDependencyNode.h>
+#include <maya/MSceneMessage.h>
 
 #include "point-distribution.h"
 #include "util.h"
+#include "core/kd-tree.h"
+#include "core/fracture.h"
+#include "core/mesh-io.h"
 
 VoronoiFracture::VoronoiFracture() {};
 
-VoronoiFracture::~VoronoiFracture() {};
+VoronoiFracture::~VoronoiFracture()
+{
+    // Redo is no longer possible once the command is deleted
+    if (!cache_directory.empty())
+    {
+        std::error_code error;
+        std::filesystem::remove_all(cache_directory, error);
+    }
+}
 
 MStatus VoronoiFracture::doIt(const MArgList& args)
 {
     MArgDatabase arg_data(syntax(), args);
 
     num_fragments.setValue(arg_data);
+    sub_fragments.setValue(arg_data);
     delete_object.setValue(arg_data);
     curve_radius.setValue(arg_data);
     disk_axis.setValue(arg_data);
     steps.setValue(arg_data);
     step_noise.setValue(arg_data);
     min_distance.setValue(arg_data);
+    num_threads.setValue(arg_data);
+    profile.setValue(arg_data);
+    trace.setValue(arg_data);
+    contacts.setValue(arg_data);
+    verbosity.setValue(arg_data);
+    seed.setValue(arg_data);
+    batch_size.setValue(arg_data);
+    clip_type_name.setValue(arg_data);
+    seed_order_name.setValue(arg_data);
 
     // Must be > 0
     if (step_noise < 1e-6) step_noise = 1e-6;
 
+    if ((MString)clip_type_name == "internal")
+        clip_type = ClipType::INTERNAL;
+    else if ((MString)clip_type_name == "boolean")
+        clip_type = ClipType::BOOLEAN;
+    else
+    {
+        displayError("-clip_type must be internal or boolean.");
+        return MS::kInvalidParameter;
+    }
+
+    if ((MString)seed_order_name == "none")
+        seed_order = PointDistribution::Curve::NONE;
+    else if ((MString)seed_order_name == "morton")
+        seed_order = PointDistribution::Curve::MORTON;
+    else if ((MString)seed_order_name == "hilbert")
+        seed_order = PointDistribution::Curve::HILBERT;
+    else
+    {
+        displayError("-seed_order must be none, morton or hilbert.");
+        return MS::kInvalidParameter;
+    }
+
+    const auto level = static_cast<Log::Level>(std::min((unsigned)verbosity, (unsigned)Log::Level::DEBUG));
+    logger = std::make_unique<Log::Logger>(level, [](Log::Level l, const std::string& message)
+    {
+        if (l == Log::Level::ERROR) displayError(message.c_str());
+        else if (l == Log::Level::WARNING) displayWarning(message.c_str());
+        else displayInfo(message.c_str());
+    });
+
+    MStatus status = fracture();
+
+    // Flushes buffered messages
+    logger.reset();
+
+    return status;
+}
+
+MStatus VoronoiFracture::fracture()
+{
     MSelectionList list;
     MGlobal::getActiveSelectionList(list);
 
@@ -62,110 +126,464 @@ MStatus VoronoiFracture::doIt(const MArgList& args)
     it.getDagPath(node);
 
     MFnDagNode node_fn(node);
-    displayInfo(MString("Fracturing ") + node_fn.fullPathName());
-
-    // Transformation matrix
-    MMatrix M = node.inclusiveMatrix();
-    MMatrix M_inv = M.inverse();
 
     MBoundingBox BB = node_fn.boundingBox();
-    BB.transformUsing(M);
+    BB.transformUsing(node.inclusiveMatrix());
 
-    MVector extent = BB.max() - BB.min();
-    double clip_triangle_half_extent = extent.length() * 10.0;
+    if (profile || ((MString)trace).length() > 0) profiler = std::make_unique<Profiling::Profiler>();
 
-    const std::vector<MPoint> points = generateSeedPoints(BB, list);
+    ThreadPool pool(num_threads);
+
+    // 0 draws a new seed, which is logged so the result can be reproduced
+    const uint64_t random_seed = seed != 0u ? (uint64_t)seed : Random::randomSeed() & 0xFFFFFFFF;
+
+    std::vector<Geometry::Vec3> seeds;
+    {
+        Profiling::Profiler::Scope scope(profiler.get(), "generateSeedPoints");
+        seeds = generateSeedPoints(BB, list, random_seed, pool);
+    }
 
-    if (points.empty())
+    if (seeds.empty())
     {
         displayError("Generated point distribution is empty.");
         return MS::kFailure;
     }
 
-    // Vector of pointers to seed points used for separate sorting
-    std::vector<std::vector<MPoint>::const_iterator> point_ptrs(points.size());
-    std::generate(point_ptrs.begin(), point_ptrs.end(), [b = points.begin()]() mutable { return b++; });
+    auto begin = std::chrono::high_resolution_clock::now();
 
-    MDagPathArray fragment_paths;
-    MStatus status = generateFragmentMeshes(node_fn.fullPathName().asChar(), points.size(), fragment_paths);
+    Geometry::PlaneTestStats plane_stats;
+    size_t num_created = 0;
+
+    MStatus status;
+    if (clip_type == ClipType::INTERNAL)
+        status = internalFracture(node, seeds, BB, random_seed, pool, plane_stats, num_created);
+    else
+    {
+        if ((unsigned)sub_fragments > 0 || (unsigned)batch_size > 0)
+            LOG(*logger, Log::Level::WARNING, "-sub_fragments and -batch_size are ignored with boolean clipping.");
+        if (((MString)contacts).length() > 0)
+            LOG(*logger, Log::Level::WARNING, "-contacts is ignored with boolean clipping.");
+        status = booleanFracture(node, seeds, BB, plane_stats, num_created);
+    }
+
+    if (!status) return status;
+
+    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - begin);
+    LOG(*logger, Log::Level::INFO, "Fractured " << node_fn.fullPathName().asChar() << " into " << num_created
+        << " fragments from " << seeds.size() << " seeds in " << duration.count() * 1e-6 << " seconds, seed " << random_seed << ".");
+    LOG(*logger, Log::Level::DEBUG, "Planes resolved by bounding sphere: " << plane_stats.sphere << ", bounding box: " << plane_stats.box
+        << ", vertices: " << plane_stats.vertices << ". Planes clipped: " << plane_stats.clipped << ".");
+
+    if (clip_type == ClipType::INTERNAL)
+    {
+        source_transform = node.transform();
+        status = redoIt();
+    }
+    else
+    {
+        // Delete original objects
+        if (delete_object) dag_modifier.deleteNode(node.transform());
+
+        Profiling::Profiler::Scope scope(profiler.get(), "modifier");
+        dag_modifier.doIt();
+    }
+
+    if (profiler)
+    {
+        if (profile) setResult(MString(profiler->report().c_str()));
+
+        if (((MString)trace).length() > 0 && !profiler->writeChromeTrace(((MString)trace).asChar()))
+            LOG(*logger, Log::Level::WARNING, "Could not write trace to " << ((MString)trace).asChar());
+
+        // Redo isn't profiled
+        profiler.reset();
+    }
+
+    return status;
+}
+
+// Creates the computed fragments in the scene. All nodes are created, parented, named and 
+// deleted through a single modifier so that undo and redo don't recompute anything.
+MStatus VoronoiFracture::redoIt()
+{
+    if (clip_type != ClipType::INTERNAL) return MS::kSuccess;
+
+    MStatus status;
+
+    // Streamed fragments are only on disk
+    const size_t num_results = fragment_files.empty() ? fragments.size() : fragment_files.size();
+
+    const bool first = !created;
+    if (first)
+    {
+        created = true;
+
+        Profiling::Profiler::Scope scope(profiler.get(), "createNodes");
+
+        MObject group = dag_modifier.createNode("transform", MObject::kNullObj, &status);
+        if (!status)
+        {
+            displayError("Unable to create fragment group. " + status.errorString());
+            return status;
+        }
+        dag_modifier.renameNode(group, "fragments");
+
+        for (size_t i = 0; i < num_results; i++)
+        {
+            MString name = ("fragment_" + std::to_string(i)).c_str();
+
+            MObject transform = dag_modifier.createNode("transform", group);
+            dag_modifier.renameNode(transform, name);
+
+            MObject shape = dag_modifier.createNode("mesh", transform);
+            dag_modifier.renameNode(shape, name + "Shape");
+
+            fragment_transforms.push_back(transform);
+            fragment_shapes.push_back(shape);
+        }
+
+        if (delete_object) dag_modifier.deleteNode(source_transform);
+    }
+
+    {
+        Profiling::Profiler::Scope scope(profiler.get(), "modifier");
+        status = dag_modifier.doIt();
+    }
     if (!status)
     {
-        displayError("Unable to duplicate selected mesh.");
+        displayError("Unable to create fragments. " + status.errorString());
         return status;
     }
 
-    auto begin = std::chrono::high_resolution_clock::now();
-
-    std::vector<MObject> clipped;
+    Profiling::Profiler::Scope write_scope(profiler.get(), "writeMeshes");
 
-    for (unsigned int i = 0; i < points.size(); i++)
+    // The modifier can't set mesh data, it is written once the nodes exist.
+    // Fragments use the same transformation as the source, with vertices in its object space.
+    MMatrix M_inv = fragment_matrix.inverse();
+    Geometry::Mesh cached;
+    for (size_t i = 0; i < num_results; i++)
     {
-        const MPoint& p0 = points[i];
+        MFnTransform(fragment_transforms[i]).set(MTransformationMatrix(fragment_matrix));
 
-        displayInfo(("Processing fragment " + std::to_string(i) + " for point: " +
-            std::to_string(p0.x) + ", " +
-            std::to_string(p0.y) + ", " +
-            std::to_string(p0.z)).c_str()
-        );
+        if (!fragment_files.empty() && !MeshIO::read(fragment_files[i], cached))
+        {
+            displayError(("Could not read cached fragment " + fragment_files[i]).c_str());
+            return MS::kFailure;
+        }
 
-        auto fragment_path = fragment_paths[i];
-        fragment_path.extendToShape();
-        MFnMesh fragment(fragment_path, &status);
+        MFnMesh mesh_fn(fragment_shapes[i]);
+        status = setMesh(mesh_fn, fragment_files.empty() ? *fragments[i] : cached, M_inv);
         if (!status)
         {
-            displayError("Could not retrieve fragment mesh. " + status.errorString());
+            displayError("Could not write fragment mesh. " + status.errorString());
             return status;
         }
+    }
+
+    if (first && !fragment_shapes.empty())
+    {
+        MString command = "sets -e -forceElement " + MFnDependencyNode(shading_group).name();
+        for (const auto& shape : fragment_shapes)
+        {
+            MDagPath path;
+            MDagPath::getAPathTo(shape, path);
+            command += " " + path.fullPathName();
+        }
+        shading_modifier.commandToExecute(command);
+        if (profiler) profiler->script_calls++;
+    }
+
+    Profiling::Profiler::Scope scope(profiler.get(), "assignShading");
+    return shading_modifier.doIt();
+}
 
-        // Sort point pointers based on distance to p0
-        std::sort(point_ptrs.begin(), point_ptrs.end(),
-            [&p0](const auto& a, const auto& b)
+MStatus VoronoiFracture::undoIt()
+{
+    shading_modifier.undoIt();
+    return dag_modifier.undoIt();
+}
+
+bool VoronoiFracture::isUndoable() const
+{
+    return clip_type == ClipType::INTERNAL;
+}
+
+// Fractures the mesh in memory, the fragments are created in the scene by redoIt
+MStatus VoronoiFracture::internalFracture(const MDagPath& node, const std::vector<Geometry::Vec3>& seeds, const MBoundingBox& BB, uint64_t random_seed, ThreadPool& pool, Geometry::PlaneTestStats& plane_stats, size_t& num_created)
+{
+    MDagPath shape = node;
+    shape.extendToShape();
+    MFnMesh source_fn(shape);
+
+    fragment_matrix = node.inclusiveMatrix();
+
+    Geometry::Mesh source;
+    {
+        Profiling::Profiler::Scope scope(profiler.get(), "readMesh");
+        source = getMesh(source_fn, MSpace::kWorld);
+    }
+
+    const Geometry::Vec3 min = toVec3(BB.min()), max = toVec3(BB.max());
+
+    // Fragments of a closed mesh must be closed as well
+    size_t num_open = 0;
+
+    // Fragment pairs sharing a face, renumbered like the created fragments
+    const bool write_contacts = ((MString)contacts).length() > 0;
+    std::vector<Fracture::Contact> fragment_contacts;
+
+    if ((unsigned)batch_size > 0)
+    {
+        if ((unsigned)sub_fragments > 0) LOG(*logger, Log::Level::WARNING, "-sub_fragments is ignored with -batch_size.");
+
+        MStatus status = streamFracture(source, seeds, min, max, pool, plane_stats, num_open, write_contacts ? &fragment_contacts : nullptr);
+        if (!status) return status;
+    }
+    else
+    {
+        const uint64_t key = Fracture::hashInputs(source, min, max);
+        if (fracture_cache && fracture_cache->key == key)
+        {
+            Profiling::Profiler::Scope scope(profiler.get(), "refracture");
+
+            // Commands in the undo queue share the fragments they created, refracture replaces
+            // rebuilt and renumbered ones in the cache instead of changing them
+            size_t rebuilt = Fracture::refracture(fracture_cache->level, source, seeds, min, max, pool, &plane_stats, profiler.get());
+            LOG(*logger, Log::Level::DEBUG, "Rebuilt " << rebuilt << " of " << seeds.size() << " cells.");
+        }
+        else
+        {
+            Profiling::Profiler::Scope scope(profiler.get(), "fractureLevel");
+
+            fracture_cache = std::make_unique<FractureCache>();
+            fracture_cache->key = key;
+            fracture_cache->level = Fracture::fractureLevel(source, seeds, min, max, pool, &plane_stats, profiler.get());
+        }
+
+        // Level of the results, the fine one in hierarchical mode
+        const Fracture::Level* result = &fracture_cache->level;
+        Fracture::Level fine;
+
+        if ((unsigned)sub_fragments > 0)
+        {
+            Profiling::Profiler::Scope scope(profiler.get(), "subFracture");
+
+            fine = Fracture::subFracture(fracture_cache->level, sub_fragments, random_seed, min_distance, pool, &plane_stats, profiler.get());
+            result = &fine;
+        }
+        if (write_contacts) fragment_contacts = Fracture::contacts(*result);
+
+        if (logger->enabled(Log::Level::DEBUG))
+        {
+            for (size_t i = 0; i < result->fragments.size(); i++)
             {
-                return p0.distanceTo(*a) < p0.distanceTo(*b);
+                const Geometry::Vec3& p = result->seeds[i];
+                LOG(*logger, Log::Level::DEBUG, "Fragment " << i << " for point: " << p.x << ", " << p.y << ", " << p.z
+                    << " has " << result->fragments[i]->polygon_counts.size() << " faces.");
             }
-        );
+        }
+
+        // Seeds whose cell missed the mesh don't get a fragment, nor a number in the contacts
+        if (write_contacts)
+        {
+            std::vector<size_t> numbers(result->fragments.size());
+            for (size_t i = 0, n = 0; i < numbers.size(); i++) numbers[i] = result->fragments[i]->empty() ? 0 : n++;
+            Fracture::renumberContacts(fragment_contacts, numbers);
+        }
 
-        const auto& p0_ptr = points.begin() + i;
+        for (const auto& fragment : result->fragments)
+        {
+            if (!fragment->empty()) fragments.push_back(fragment);
+        }
 
-        for (const auto &p1_ptr : point_ptrs)
+        if (Geometry::isClosed(source))
         {
-            if (p0_ptr == p1_ptr) continue;
+            num_open = std::count_if(fragments.begin(), fragments.end(), [](const std::shared_ptr<const Geometry::Mesh>& m) { return !Geometry::isClosed(*m); });
+        }
+    }
+    if (num_open > 0) LOG(*logger, Log::Level::WARNING, num_open << " fragments of the closed mesh are not watertight.");
 
-            Plane clip_plane = getBisectorPlane(p0, *p1_ptr);
+    if (write_contacts && !Fracture::writeContacts(((MString)contacts).asChar(), fragment_contacts))
+        LOG(*logger, Log::Level::WARNING, "Could not write contacts to " << ((MString)contacts).asChar());
 
-            // This in combination with sorting improves performance a lot
-            bool is_clipped;
-            if (!clip_plane.intersects(fragment, is_clipped))
+    num_created = fragments.empty() ? fragment_files.size() : fragments.size();
+
+    // Fragments use the first shading group of the source mesh
+    MObjectArray shaders;
+    MIntArray shader_indices;
+    source_fn.getConnectedShaders(shape.instanceNumber(), shaders, shader_indices);
+
+    if (shaders.length() > 0)
+    {
+        shading_group = shaders[0];
+    }
+    else
+    {
+        MSelectionList shading_list;
+        shading_list.add("initialShadingGroup");
+        shading_list.getDependNode(0, shading_group);
+    }
+
+    return MS::kSuccess;
+}
+
+// Fractures in batches of spatially close seeds and writes every fragment to a disk cache as
+// its batch completes, so memory doesn't grow with the number of fragments. redoIt reads
+// them back one at a time. Contacts, if given, are numbered like the cached fragments.
+MStatus VoronoiFracture::streamFracture(const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds, const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool, Geometry::PlaneTestStats& plane_stats, size_t& num_open, std::vector<Fracture::Contact>* contacts)
+{
+    std::vector<size_t> numbers(contacts ? seeds.size() : 0);
+
+    const bool source_closed = Geometry::isClosed(source);
+
+    std::error_code error;
+    cache_directory = std::filesystem::temp_directory_path(error) / formatString("voronoiFracture-%016llx", (unsigned long long)Random::randomSeed()).asChar();
+    if (!error) std::filesystem::create_directories(cache_directory, error);
+    if (error)
+    {
+        displayError(("Unable to create fragment cache. " + error.message()).c_str());
+        return MS::kFailure;
+    }
+
+    const bool completed = Fracture::fractureBatches(source, seeds, min, max, pool, batch_size,
+        [&](size_t i, Geometry::Mesh& fragment)
+        {
+            LOG(*logger, Log::Level::DEBUG, "Fragment " << i << " for point: " << seeds[i].x << ", " << seeds[i].y << ", " << seeds[i].z
+                << " has " << fragment.polygon_counts.size() << " faces.");
+
+            if (source_closed && !Geometry::isClosed(fragment)) num_open++;
+            if (contacts)
             {
-                if (is_clipped)
-                {
-                    clipped.push_back(fragment_paths[i].transform());
-                    break;
-                }
-                continue;
+                Fracture::addContacts(fragment, i, *contacts);
+                numbers[i] = fragment_files.size();
             }
 
-            if constexpr (CLIP_TYPE == ClipType::BOOLEAN)
+            const std::string file = (cache_directory / ("fragment_" + std::to_string(i) + ".ply")).string();
+            if (!MeshIO::write(file, fragment)) return false;
+
+            fragment_files.push_back(file);
+            return true;
+        },
+        &plane_stats, profiler.get()
+    );
+
+    if (!completed)
+    {
+        displayError(("Unable to write fragment cache to " + cache_directory.string()).c_str());
+        return MS::kFailure;
+    }
+
+    if (contacts) Fracture::renumberContacts(*contacts, numbers);
+
+    return MS::kSuccess;
+}
+
+// Fractures duplicates of the mesh in the scene. Each duplicate is intersected once with the
+// convex volume of its Voronoi cell, which is as robust as intersecting with a volume per
+// bisector plane and needs a single boolean operation per fragment.
+MStatus VoronoiFracture::booleanFracture(const MDagPath& node, const std::vector<Geometry::Vec3>& seeds, const MBoundingBox& BB, Geometry::PlaneTestStats& plane_stats, size_t& num_created)
+{
+    MFnDagNode node_fn(node);
+
+    // MFnMesh::booleanOps operates in object space
+    MMatrix M_inv = node.inclusiveMatrix().inverse();
+
+    MDagPath shape = node;
+    shape.extendToShape();
+
+    // World space vertices of the source, which every fragment starts as
+    const Geometry::VertexBuffer vertices = getVertexBuffer(MFnMesh(shape));
+    const bool source_closed = Geometry::isClosed(getMesh(MFnMesh(shape), MSpace::kObject));
+
+    const KdTree<Geometry::Vec3> seed_index(seeds);
+    Geometry::CellBuilder builder;
+    Geometry::VoronoiCell cell;
+
+    MDagPathArray fragment_paths;
+    MStatus status;
+    {
+        Profiling::Profiler::Scope scope(profiler.get(), "generateFragmentMeshes");
+        status = generateFragmentMeshes(node_fn.fullPathName().asChar(), seeds.size(), fragment_paths);
+    }
+    if (!status)
+    {
+        displayError("Unable to duplicate selected mesh.");
+        return status;
+    }
+
+    std::vector<MObject> clipped;
+    size_t num_open = 0;
+
+    const size_t first_profile = profiler ? profiler->addFragments(seeds.size()) : 0;
+
+    for (unsigned int i = 0; i < seeds.size(); i++)
+    {
+        const Geometry::Vec3& p0 = seeds[i];
+
+        Profiling::Profiler::Scope fragment_scope(profiler.get(), "fragment", 0, i);
+        const Geometry::PlaneTestStats before = builder.stats;
+
+        LOG(*logger, Log::Level::DEBUG, "Processing fragment " << i << " for point: " << p0.x << ", " << p0.y << ", " << p0.z);
+
+        {
+            Profiling::Profiler::Scope scope(profiler.get(), "buildCell", 0, i);
+            builder.build(seed_index, i, toVec3(BB.min()), toVec3(BB.max()), cell);
+        }
+
+        // The boolean is only needed if a face of the cell cuts the mesh, and the fragment is
+        // empty if the mesh is entirely outside of any face
+        bool empty = cell.mesh.empty(), cut = false;
+        for (size_t j = 0; j < cell.planes.size() && !empty; j++)
+        {
+            bool is_clipped;
+            if (Geometry::intersects(cell.planes[j], vertices, is_clipped, &builder.stats))
+                cut = true;
+            else
+                empty = is_clipped;
+        }
+
+        if (empty)
+        {
+            clipped.push_back(fragment_paths[i].transform());
+        }
+        else if (cut)
+        {
+            auto fragment_path = fragment_paths[i];
+            fragment_path.extendToShape();
+            MFnMesh fragment(fragment_path, &status);
+            if (!status)
             {
-                // MFnMesh::booleanOps operates in object space
-                clip_plane = getBisectorPlane(p0 * M_inv, *p1_ptr * M_inv);
-                status = booleanClipAndCap(fragment, clip_plane, clip_triangle_half_extent);
+                displayError("Could not retrieve fragment mesh. " + status.errorString());
+                return status;
             }
-            else
+
             {
-                status = internalClipAndCap(fragment, clip_plane);
+                Profiling::Profiler::Scope scope(profiler.get(), "booleanIntersect", 0, i);
+                status = booleanIntersect(fragment, cell.mesh, M_inv);
             }
+            builder.stats.clipped++;
 
             if (!status)
             {
-                displayError("Could not execute clip and cap.");
+                displayError("Could not intersect fragment with its cell. " + status.errorString());
                 return status;
             }
+
+            // The cell may only cut away parts of the mesh that other cells keep
+            if (fragment.numPolygons() == 0)
+                clipped.push_back(fragment_paths[i].transform());
+            else if (source_closed && !Geometry::isClosed(getMesh(fragment, MSpace::kObject)))
+                num_open++;
         }
+
+        if (profiler) profiler->fragments[first_profile + i].planes = builder.stats - before;
     }
 
-    auto duration = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::high_resolution_clock::now() - begin);
-    displayInfo(("Fracture time: " + std::to_string(duration.count() * 1e-6) + " seconds.").c_str());
+    plane_stats += builder.stats;
+
+    if (num_open > 0) LOG(*logger, Log::Level::WARNING, num_open << " fragments of the closed mesh are not watertight.");
+
+    Profiling::Profiler::Scope cleanup_scope(profiler.get(), "modifier");
 
     if (clipping_mesh)
     {
@@ -173,11 +591,9 @@ MStatus VoronoiFracture::doIt(const MArgList& args)
         clipping_mesh.reset();
     }
 
-    // Delete original objects
-    if (delete_object) dag_modifier.deleteNode(node.transform());
-
     // Delete clipped fragments
     for (auto& o : clipped) dag_modifier.deleteNode(o);
+    num_created = seeds.size() - clipped.size();
 
     dag_modifier.doIt();
 
@@ -200,79 +616,85 @@ void* VoronoiFracture::creator()
     return new VoronoiFracture();
 }
 
+MStatus VoronoiFracture::addCallbacks()
+{
+    MStatus status;
+    for (MSceneMessage::Message message : { MSceneMessage::kBeforeNew, MSceneMessage::kBeforeOpen })
+    {
+        MCallbackId id = MSceneMessage::addCallback(message, [](void*) { fracture_cache.reset(); }, nullptr, &status);
+        if (!status) return status;
+        callback_ids.append(id);
+    }
+    return status;
+}
+
+void VoronoiFracture::removeCallbacks()
+{
+    MMessage::removeCallbacks(callback_ids);
+    callback_ids.clear();
+    fracture_cache.reset();
+}
+
 MSyntax VoronoiFracture::syntaxCreator()
 {
     MSyntax syntax;
     num_fragments.addToSyntax(syntax);
+    sub_fragments.addToSyntax(syntax);
     delete_object.addToSyntax(syntax);
     curve_radius.addToSyntax(syntax);
     disk_axis.addToSyntax(syntax);
     steps.addToSyntax(syntax);
     step_noise.addToSyntax(syntax);
     min_distance.addToSyntax(syntax);
+    num_threads.addToSyntax(syntax);
+    profile.addToSyntax(syntax);
+    trace.addToSyntax(syntax);
+    contacts.addToSyntax(syntax);
+    verbosity.addToSyntax(syntax);
+    seed.addToSyntax(syntax);
+    batch_size.addToSyntax(syntax);
+    clip_type_name.addToSyntax(syntax);
+    seed_order_name.addToSyntax(syntax);
     return syntax;
 }
 
-// Mesh clip and cap using internal commands polyCut and polyCloseBorder
-MStatus VoronoiFracture::internalClipAndCap(MFnMesh& object, const Plane& clip_plane)
+// Replaces object with its intersection with the convex cell, given in world space
+MStatus VoronoiFracture::booleanIntersect(MFnMesh& object, const Geometry::Mesh& cell, const MMatrix& M_inv)
 {
-    const MVector& n = clip_plane.normal;
-    const MVector& p = clip_plane.point;
-
-    return MGlobal::executePythonCommand(formatString(
-        "Util.clipAndCap('%s', [%f,%f,%f], [%f,%f,%f])", 
-        object.fullPathName().asChar(), -n.x, -n.y, -n.z, p.x, p.y, p.z
-    ));
-}
+    MPointArray points((unsigned)cell.vertices.size());
+    for (unsigned int i = 0; i < points.length(); i++)
+    {
+        const Geometry::Vec3& v = cell.vertices[i];
+        points[i] = MPoint(v.x, v.y, v.z) * M_inv;
+    }
 
-// Mesh clip and cap using boolean intersection from C++ api
-MStatus VoronoiFracture::booleanClipAndCap(MFnMesh& object, const Plane& clip_plane, double half_extent)
-{
-    // Legacy mode using triangle plane is way faster (19 sec for 1000 fragments), but 
-    // this produces artefacts in edge cases. Non-legacy is more robust but requires 
-    // an intersection volume instead, for which a tetrahedra is generated.
-    constexpr bool LEGACY = false;
+    MIntArray counts(cell.polygon_counts.data(), (unsigned)cell.polygon_counts.size());
+    MIntArray connects(cell.polygon_connects.data(), (unsigned)cell.polygon_connects.size());
 
+    // One mesh is reused for all cells, it is deleted with the clipped fragments
+    MStatus status;
     if (!clipping_mesh)
     {
         clipping_mesh = std::make_unique<MFnMesh>();
-
-        if constexpr (LEGACY)
-        {
-            constexpr int indices[] = { 0, 1, 2 };
-            (void)clipping_mesh->create(3, 1, MPointArray(3), MIntArray(1, 3), MIntArray(indices, 3));
-        }
-        else
-        {
-            constexpr int indices[] = { 0, 1, 2, /**/ 0, 3, 1, /**/ 0, 2, 3, /**/ 1, 3, 2 };
-            (void)clipping_mesh->create(4, 4, MPointArray(4), MIntArray(4, 3), MIntArray(indices, 12));
-        }
+        clipping_mesh->create(points.length(), counts.length(), points, counts, connects, MObject::kNullObj, &status);
     }
-
-    // Generate arbitrary orthonormal basis for plane, (X, Y, clip_plane.normal).
-    MVector X = orthogonalUnitVector(clip_plane.normal);
-    MVector Y = clip_plane.normal ^ X;
-
-    const auto& p = clip_plane.point;
-
-    for (int i = 0; i < 3; i++)
+    else
     {
-        double a = i * 2.0 * M_PI / 3.0;
-        clipping_mesh->setPoint(i, p + X * half_extent * std::cos(a) + Y * half_extent * std::sin(a));
+        status = clipping_mesh->createInPlace(points.length(), counts.length(), points, counts, connects);
     }
-
-    if constexpr (!LEGACY) clipping_mesh->setPoint(3, p - clip_plane.normal * half_extent);
+    if (!status) return status;
 
     MObjectArray objects;
     objects.append(object.object());
     objects.append(clipping_mesh->object());
 
-    return object.booleanOps(MFnMesh::kIntersection, objects, LEGACY);
+    return object.booleanOps(MFnMesh::kIntersection, objects);
 }
 
 MStatus VoronoiFracture::generateFragmentMeshes(const char* object, size_t num, MDagPathArray& fragment_paths)
 {
     MString group_name;
+    if (profiler) profiler->script_calls++;
     MStatus status = MGlobal::executePythonCommand(formatString(
         "Util.multiDuplicate('%s', %d, 'fragments')", object, num), group_name
     );
@@ -296,9 +718,9 @@ MStatus VoronoiFracture::generateFragmentMeshes(const char* object, size_t num,
     return MS::kSuccess;
 }
 
-std::vector<MPoint> VoronoiFracture::generateSeedPoints(const MBoundingBox& BB, const MSelectionList& list)
+std::vector<Geometry::Vec3> VoronoiFracture::generateSeedPoints(const MBoundingBox& BB, const MSelectionList& list, uint64_t random_seed, ThreadPool& pool)
 {
-    std::vector<MPoint> points;
+    std::vector<Geometry::Vec3> points;
 
     MItSelectionList sphere_it(list, MFn::kImplicitSphere);
     MItSelectionList curve_it(list, MFn::kNurbsCurve);
@@ -312,53 +734,30 @@ std::vector<MPoint> VoronoiFracture::generateSeedPoints(const MBoundingBox& BB,
         MFnDagNode node_fn(node);
         MPlug radius_plug = node_fn.findPlug("radius", true);
 
-        displayInfo(MString("Using ") + node_fn.fullPathName());
-
-        double radius = radius_plug.asDouble();
-        MMatrix M = node.inclusiveMatrix();
-        MPoint position = MTransformationMatrix(M).getTranslation(MSpace::kWorld);
+        LOG(*logger, Log::Level::DEBUG, "Using " << node_fn.fullPathName().asChar());
 
         unsigned disk_axis_i = 0;
         if ((MString)disk_axis == "x") disk_axis_i = 1;
         else if ((MString)disk_axis == "y") disk_axis_i = 2;
         else if ((MString)disk_axis == "z") disk_axis_i = 3;
 
-        MTransformationMatrix axes_transform(M);
-        axes_transform.setTranslation(MVector(0, 0, 0), MSpace::kWorld);
-        MMatrix M_axes = axes_transform.asMatrix();
-
-        std::array<MVector, 3> axes = {
-            MVector(radius, 0, 0) * M_axes,
-            MVector(0, radius, 0) * M_axes,
-            MVector(0, 0, radius) * M_axes
-        };
-
-        if (disk_axis_i == 0)
-        {
-            if ((unsigned)steps == 0)
-                points = PointDistribution::sphereQuadratic(position, axes, num_fragments);
-            else
-                points = PointDistribution::sphereSteps(position, axes, steps, step_noise, num_fragments);
-        }
-        else
-        {
-            if ((unsigned)steps == 0)
-                points = PointDistribution::diskQuadratic(position, axes, disk_axis_i, num_fragments);
-            else
-                points = PointDistribution::diskSteps(position, axes, steps, disk_axis_i, step_noise, num_fragments);
-        }
+        points = PointDistribution::implicitSphere(node.inclusiveMatrix(), radius_plug.asDouble(), disk_axis_i, steps, step_noise, num_fragments, random_seed, &pool);
     }
     else if (!curve_it.isDone())
     {
-        MDagPath node;
-        curve_it.getDagPath(node);
-        MFnDagNode node_fn(node);
+        // All selected curves are used, seeds are spread over them by length
+        std::vector<PointDistribution::CurveTable> curves;
+        for (; !curve_it.isDone(); curve_it.next())
+        {
+            MDagPath node;
+            curve_it.getDagPath(node);
 
-        displayInfo(MString("Using ") + node_fn.fullPathName());
+            LOG(*logger, Log::Level::DEBUG, "Using " << node.fullPathName().asChar());
 
-        MFnNurbsCurve curve(node);
+            curves.push_back(PointDistribution::sampleCurve(MFnNurbsCurve(node)));
+        }
 
-        points = PointDistribution::curve(curve, curve_radius, num_fragments);
+        points = PointDistribution::curves(curves, curve_radius, num_fragments, random_seed, &pool);
     }
     else if (!particle_it.isDone())
     {
@@ -366,7 +765,7 @@ std::vector<MPoint> VoronoiFracture::generateSeedPoints(const MBoundingBox& BB,
         particle_it.getDagPath(node);
         MFnDagNode node_fn(node);
 
-        displayInfo(MString("Using ") + node_fn.fullPathName());
+        LOG(*logger, Log::Level::DEBUG, "Using " << node_fn.fullPathName().asChar());
 
         MFnParticleSystem particles(node);
 
@@ -374,10 +773,15 @@ std::vector<MPoint> VoronoiFracture::generateSeedPoints(const MBoundingBox& BB,
     }
     else
     {
-        points = PointDistribution::uniformBoundingBox(BB.min(), BB.max(), num_fragments);
+        points = PointDistribution::uniformBoundingBox(toVec3(BB.min()), toVec3(BB.max()), num_fragments, random_seed, &pool);
     }
 
-    points = PointDistribution::removeDuplicates(points, min_distance);
+    {
+        Profiling::Profiler::Scope scope(profiler.get(), "removeDuplicates");
+        points = PointDistribution::removeDuplicates(points, min_distance);
+    }
 
-    return points;
+    // Neighbouring seeds then share cache lines in the seed index and land on the same worker
+    Profiling::Profiler::Scope scope(profiler.get(), "sortSeeds");
+    return PointDistribution::sortSpatially(points, seed_order);
 }
\ No newline at end of file
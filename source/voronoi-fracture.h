@@ -1,14 +1,26 @@
 #pragma once
 
 #include <vector>
+#include <memory>
+#include <string>
+#include <filesystem>
 
 #include <maya/MPxCommand.h>
 #include <maya/MSyntax.h>
 #include <maya/MArgDatabase.h>
 #include <maya/MDagModifier.h>
+#include <maya/MDGModifier.h>
+#include <maya/MMatrix.h>
 #include <maya/MPoint.h>
+#include <maya/MCallbackIdArray.h>
 
-struct Plane;
+#include "core/vertex-buffer.h"
+#include "core/profiler.h"
+#include "core/log.h"
+#include "core/thread-pool.h"
+#include "core/fracture.h"
+#include "core/contacts.h"
+#include "core/point-distribution.h"
 
 class VoronoiFracture : public MPxCommand
 {
@@ -17,17 +29,31 @@ public:
     ~VoronoiFracture() override;
 
     MStatus doIt(const MArgList& args) override;
+    MStatus redoIt() override;
+    MStatus undoIt() override;
+    bool isUndoable() const override;
     static void* creator();
     static MSyntax syntaxCreator();
 
+    // Drop the cache of the last fracture when a scene is created or opened, called when the
+    // plugin is loaded and unloaded
+    static MStatus addCallbacks();
+    static void removeCallbacks();
+
 private:
-    MStatus internalClipAndCap(MFnMesh& object, const Plane& clip_plane);
-    MStatus booleanClipAndCap(MFnMesh& object, const Plane& clip_plane, double half_extent);
+    MStatus fracture();
+
+    // Both return the number of fragments created in num_created
+    MStatus internalFracture(const MDagPath& node, const std::vector<Geometry::Vec3>& seeds, const MBoundingBox& BB, uint64_t random_seed, ThreadPool& pool, Geometry::PlaneTestStats& plane_stats, size_t& num_created);
+    MStatus streamFracture(const Geometry::Mesh& source, const std::vector<Geometry::Vec3>& seeds, const Geometry::Vec3& min, const Geometry::Vec3& max, ThreadPool& pool, Geometry::PlaneTestStats& plane_stats, size_t& num_open, std::vector<Fracture::Contact>* contacts);
+    MStatus booleanFracture(const MDagPath& node, const std::vector<Geometry::Vec3>& seeds, const MBoundingBox& BB, Geometry::PlaneTestStats& plane_stats, size_t& num_created);
+
+    MStatus booleanIntersect(MFnMesh& object, const Geometry::Mesh& cell, const MMatrix& M_inv);
 
     MStatus generateFragmentMeshes(const char* object, size_t num, MDagPathArray& fragment_paths);
 
     // Generates seed points in world space
-    std::vector<MPoint> generateSeedPoints(const MBoundingBox &BB, const MSelectionList& list);
+    std::vector<Geometry::Vec3> generateSeedPoints(const MBoundingBox &BB, const MSelectionList& list, uint64_t random_seed, ThreadPool& pool);
 
     template<class T, MSyntax::MArgType TYPE>
     struct Flag
@@ -55,19 +81,69 @@ private:
         const char *FLAG, *SHORT;
     };
 
+    // Internal clipping computes fragments in memory and is undoable, boolean clipping
+    // intersects duplicates in the scene with MFnMesh::booleanOps
     enum class ClipType { INTERNAL, BOOLEAN };
 
-    static const ClipType CLIP_TYPE = ClipType::INTERNAL;
+    ClipType clip_type = ClipType::INTERNAL;
+
+    // Seeds and fragments are ordered along a space filling curve, or as generated
+    PointDistribution::Curve seed_order = PointDistribution::Curve::NONE;
 
     inline static Flag num_fragments = Flag<unsigned, MSyntax::kUnsigned>("-num_fragments", "-nf", 5u);
+    inline static Flag sub_fragments = Flag<unsigned, MSyntax::kUnsigned>("-sub_fragments", "-sf", 0u);
     inline static Flag delete_object = Flag<bool, MSyntax::kBoolean>("-delete_object", "-do", true);
     inline static Flag curve_radius  = Flag<double, MSyntax::kDouble>("-curve_radius", "-cr", 0.1);
     inline static Flag disk_axis     = Flag<MString, MSyntax::kString>("-disk_axis", "-da", "");
     inline static Flag steps         = Flag<unsigned, MSyntax::kUnsigned>("-steps", "-s", 0);
     inline static Flag step_noise    = Flag<double, MSyntax::kDouble>("-step_noise", "-sn", 0.05);
-    inline static Flag min_distance  = Flag<double, MSyntax::kDouble>("-min_distance", "-md", 1e-2);
+    inline static Flag min_distance  = Flag<double, MSyntax::kDouble>("-min_distance", "-md", 0.0);
+    inline static Flag num_threads   = Flag<unsigned, MSyntax::kUnsigned>("-num_threads", "-nt", 0);
+    inline static Flag profile       = Flag<bool, MSyntax::kBoolean>("-profile", "-p", false);
+    inline static Flag trace         = Flag<MString, MSyntax::kString>("-trace", "-tr", "");
+    inline static Flag contacts      = Flag<MString, MSyntax::kString>("-contacts", "-con", "");
+    inline static Flag verbosity     = Flag<unsigned, MSyntax::kUnsigned>("-verbosity", "-vb", 2);
+    inline static Flag seed          = Flag<unsigned, MSyntax::kUnsigned>("-seed", "-sd", 0);
+    inline static Flag batch_size    = Flag<unsigned, MSyntax::kUnsigned>("-batch_size", "-bs", 0);
+    inline static Flag clip_type_name = Flag<MString, MSyntax::kString>("-clip_type", "-ct", "internal");
+    inline static Flag seed_order_name = Flag<MString, MSyntax::kString>("-seed_order", "-so", "none");
 
     MDagModifier dag_modifier;
+    MDGModifier shading_modifier;
+
+    // Computed fragments in world space, kept for redo. Without -sub_fragments they are shared
+    // with the fracture cache instead of copied.
+    std::vector<std::shared_ptr<const Geometry::Mesh>> fragments;
+
+    // Files of streamed fragments instead, removed with the command
+    std::vector<std::string> fragment_files;
+    std::filesystem::path cache_directory;
+    MMatrix fragment_matrix;
+    MObject shading_group;
+    MObject source_transform;
+
+    std::vector<MObject> fragment_transforms;
+    std::vector<MObject> fragment_shapes;
+    bool created = false;
 
     std::unique_ptr<MFnMesh> clipping_mesh;
+
+    // Cells and fragments of the last internal fracture, the coarse level in hierarchical
+    // mode. Later commands on a mesh and bounds with the same key only rebuild the cells
+    // whose seeds or neighbours changed. Fragments shared with commands in the undo queue are
+    // replaced instead of changed, so a rerun only copies the fragments it renumbers.
+    struct FractureCache
+    {
+        uint64_t key = 0;
+        Fracture::Level level;
+    };
+    inline static std::unique_ptr<FractureCache> fracture_cache;
+
+    inline static MCallbackIdArray callback_ids;
+
+    // Only set while doIt runs with -profile or -trace
+    std::unique_ptr<Profiling::Profiler> profiler;
+
+    // Only set while doIt runs, flushed to the script editor when it returns
+    std::unique_ptr<Log::Logger> logger;
 };